@@ -4,6 +4,28 @@
 #include "heartRate.h"  // For calculations
 #include "HWCDC.h"     // For USB serial on ESP32-S3
 #include <Arduino_GFX_Library.h>  // For display
+#include "goertzel_hr.h"  // Low-power HR engine
+#include "hr_tracker.h"   // Viterbi HR smoothing across windows
+#include "sample_ring.h"  // Shared sample history, PPG_CHANNELS profile
+#include "autocorr_hr.h"  // Incremental autocorrelation HR engine
+#include "regression_spo2.h"  // Peak-free SpO2 engine
+#include "nn_hr.h"           // Int8 CNN HR engine
+#include "pulse_morphology.h"  // Per-beat pulse-wave features
+#include "template_beat_detector.h"  // Template-matched beats for low perfusion
+#include "event_capture.h"  // Raw capture around events
+#include "multi_window.h"   // Short and long windows over shared intermediates
+#include "vitals_fusion.h"  // Kalman fusion of all engines
+#include "contact_detector.h"  // Proximity gating of acquisition
+#include "checkpoint.h"        // Estimator state across deep sleep
+#include "telemetry.h"         // Delta-only vitals reports
+#include "swinging_door.h"     // Piecewise-linear vitals tracks for storage
+#include "flash_log.h"         // Power-fail tolerant flash log
+#include "profiler.h"          // Timer-driven PC sampling
+#include "debug_log.h"         // Leveled logs, LOG_LEVEL / LOG_DEFERRED in debug_log.h
+#include "fast_math.h"         // Table + Newton reciprocal, sqrt and log
+#include "memory_plan.h"       // Static memory budget, no heap after setup()
+#include "batch_pool.h"        // Shared, reference-counted sample batches
+#include <esp_sleep.h>
 
 // Display pins from your old code
 #define LCD_DC 4
@@ -24,14 +46,85 @@
 #define BAUD_RATE 115200
 #define SHORT_DELAY 1000
 
+// Ambient cancellation: a third LED slot with the LED driven at 0 mA samples
+// ambient light only, and is subtracted from red/IR as they are read. Needs a
+// part with a third slot driver (MAX30101/MAX30105 class).
+#define AMBIENT_CANCEL 0
+#if AMBIENT_CANCEL && PPG_CHANNELS >= 3
+#error "AMBIENT_CANCEL uses the third slot, which the green channel profile needs"
+#endif
+
 // Buffer Size
 #define BUFFER_SIZE  100
+#define SAMPLE_RATE  100  // Hz
+#define HOP_SIZE     25   // new samples per cycle (~0.25 sec update)
+
+// Goertzel HR bank: 24 bins at 2 bpm around the last HR
+#define GOERTZEL_BINS 24
+#define GOERTZEL_STEP_BPM 2
+#define GOERTZEL_START_BPM 90
+
+// Full-band spectrogram for the HR tracker: 54 bins at 3 bpm, 40-200 bpm
+#define TRACK_BINS 54
+#define TRACK_STEP_BPM 3
+#define TRACK_TAU_SEC 2.0f
+
+// Event capture: 5 s before / 5 s after, exported 50 lines per cycle
+#define CAPTURE_PRE_SEC 5
+#define CAPTURE_POST_SEC 5
+#define CAPTURE_LINES_PER_CYCLE 50
+#define LOW_SIGNAL_IR 50000
+#define CONTACT_LOSS_SAMPLES SAMPLE_RATE  // 1 s below LOW_SIGNAL_IR goes back to the pilot LED
+
+// Concurrent windows: fast for the display, stable for logging
+#define DISPLAY_WINDOW_SEC 2
+#define LOG_WINDOW_SEC 10
+
+// Duty cycling: after DUTY_CYCLE_HOPS hops of valid fused vitals, checkpoint
+// the estimators and deep sleep for DUTY_CYCLE_SEC. 0 runs continuously.
+#define DUTY_CYCLE_SEC 0
+#define DUTY_CYCLE_HOPS 8
+
+// Vitals telemetry: report on a change past the dead-band (at most every
+// TELEMETRY_MIN_MS) or every TELEMETRY_KEEPALIVE_MS when steady
+#define TELEMETRY_HR_DEADBAND 2
+#define TELEMETRY_SPO2_DEADBAND 1
+#define TELEMETRY_MIN_MS 1000
+#define TELEMETRY_KEEPALIVE_MS 30000
+
+// Stored vitals tracks: error bound of the piecewise-linear fit and the
+// longest segment before a point is archived anyway
+#define STORE_HR_DEVIATION 1.0f    // bpm
+#define STORE_SPO2_DEVIATION 1.0f  // %
+#define STORE_MAX_SPAN_MS 600000
+#define FLASH_LOG_PARTITION "spiffs"  // data partition of the default table, unused otherwise
+
+// Sampling profiler: PC + stage samples at PROFILE_HZ, drained over serial.
+// The rate is not a multiple of the sample rate so the two don't alias.
+#define PROFILE_ENABLE 0
+#define PROFILE_HZ 997
+#define PROFILE_LINES_PER_CYCLE 400
+#define TRACE_LINES_PER_CYCLE 100  // stage-switch trace, enabled by PROFILE_TRACE in profiler.h
+
+// Time the fast_math routines against libm once at boot
+#define FAST_MATH_BENCH 0
+// Contend the sample batch pool from both cores once at boot
+#define BATCH_POOL_BENCH 0
+// Time one NN forward pass at boot, with whatever weights are compiled in
+#define NN_BENCH 0
+
+// RAM budget for the objects in PIPELINE_OBJECTS, checked at compile time.
+// Module statics (NN activations, log and profiler rings) are listed by
+// tools/memory_report.py from the ELF.
+#define MEMORY_BUDGET_BYTES 49152  // ~35.3 KB in use
 
 HWCDC USBSerial;          // USB serial
 MAX30105 particleSensor;  // MAX30102
 
 const int bufferSize = 100;  // ~1 sec at 100 Hz
-uint32_t irBuffer[BUFFER_SIZE];
+BatchPool batchPool;         // blocks the sample ring is made of
+SampleRing sampleRing;       // samples land here once, engines read them in place
+uint32_t irBuffer[BUFFER_SIZE];  // linear window for the Maxim routine
 uint32_t redBuffer[BUFFER_SIZE];
 
 int32_t spo2;
@@ -39,111 +132,609 @@ int32_t heartRate;
 int8_t validSpo2;
 int8_t validHeartRate;
 unsigned long startTime;
+ContactDetector contact;
+bool firstRun = true;  // (re)fill the whole window after contact is made
+uint32_t ambient;  // latest LED-off reading (AMBIENT_CANCEL)
+
+GoertzelBank hrBank;
+int32_t goertzelHeartRate;
+int8_t validGoertzelHeartRate;
+unsigned long goertzelMicros;  // time spent in the bank this cycle
+
+GoertzelBank spectrumBank;
+HrTracker hrTracker;
+int32_t trackedHeartRate;
+int8_t validTrackedHeartRate;
+unsigned long trackerMicros;  // spectrum + tracker time this cycle
+
+AutocorrHR autocorrHr;
+int32_t autocorrHeartRate;
+int8_t validAutocorrHeartRate;
+unsigned long autocorrMicros;  // lag updates + estimate this cycle
+
+RegressionSpO2 regressionSpo2;
+int32_t regSpo2;
+int8_t validRegSpo2;
+unsigned long regressionMicros;  // moment updates + estimate this cycle
+
+NnHR nnHr;
+#if NN_WEIGHTS_TRAINED
+int32_t nnHeartRate;
+int8_t validNnHeartRate;
+unsigned long nnMicros;  // one inference
+#endif
+
+PulseMorphology morphology;
+unsigned long morphMicros;    // time in samples that closed a beat, this cycle
+uint8_t morphBeats;           // beats closed this cycle
+
+TemplateBeatDetector templateDetector;
+int32_t templateHeartRate;
+int8_t validTemplateHeartRate;
+unsigned long templateMicros;  // matching this cycle
+
+EventCapture capture;
+
+MultiWindowEstimator multiWindow;
+WindowEstimate displayEstimate;
+WindowEstimate logEstimate;
+unsigned long multiWindowMicros;  // block sums + both windows this cycle
+
+VitalsFusion fusion;
+int32_t fusedHeartRate;
+int32_t fusedSpo2;
+int8_t validFusedHeartRate;
+int8_t validFusedSpo2;
+unsigned long fusionMicros;
+
+VitalsTelemetry telemetry;
+SwingingDoor hrTrack;
+SwingingDoor spo2Track;
+unsigned long trackMicros;
+FlashLog flashLog;
+Profiler profiler;
+
+// Checkpoint restore and time to first valid reading
+EstimatorCheckpoint checkpoint;
+byte ledBrightness = 80;  // LED drive, carried across sleep
+bool restored;
+uint32_t trackClockMs;  // track clock at boot: 0 on a cold start, carried over timer wakes
+unsigned long validAtMs;
+uint8_t dutyValidHops;
+
+// Display setup from old code, placed statically rather than with new
+Arduino_ESP32SPI lcdBus(LCD_DC, LCD_CS, LCD_SCK, LCD_MOSI);
+Arduino_ST7789 lcd(&lcdBus, LCD_RST, 0 /* rotation */, true /* IPS */, LCD_WIDTH, LCD_HEIGHT, 0, 20, 0, 0);
+Arduino_GFX *gfx = &lcd;
+
+// Everything the pipeline holds, sized by the compiler
+#define PIPELINE_OBJECTS(X) \
+  X(sampleRing) X(batchPool) X(irBuffer) X(redBuffer) X(contact) \
+  X(hrBank) X(spectrumBank) X(hrTracker) X(autocorrHr) X(regressionSpo2) X(nnHr) \
+  X(morphology) X(templateDetector) X(capture) X(multiWindow) X(fusion) \
+  X(telemetry) X(hrTrack) X(spo2Track) X(flashLog) X(profiler) X(checkpoint) \
+  X(lcdBus) X(lcd)
+
+constexpr size_t pipelineBytes = 0 PIPELINE_OBJECTS(MEMORY_PLAN_SIZE);
+static_assert(pipelineBytes <= MEMORY_BUDGET_BYTES, "pipeline objects exceed MEMORY_BUDGET_BYTES");
 
-// Display setup from old code
-Arduino_DataBus *bus = new Arduino_ESP32SPI(LCD_DC, LCD_CS, LCD_SCK, LCD_MOSI);
-Arduino_GFX *gfx = new Arduino_ST7789(bus, LCD_RST, 0 /* rotation */, true /* IPS */, LCD_WIDTH, LCD_HEIGHT, 0, 20, 0, 0);
+#define MEMORY_PLAN_REPORT(name) DLOG(MEMORY_OBJECT, #name, (uint32_t)sizeof(name));
+
+uint32_t reportedAllocations;
+
+// The estimators a checkpoint snapshots and warm-starts
+const CheckpointEngines checkpointEngines = {&regressionSpo2, &hrBank, &spectrumBank, &hrTracker, &morphology, &fusion};
+
+// Archived track points go to the flash log, and to serial as
+// P,<track>,<ms>,<value> (empty value: gap start). The ms are on the track
+// clock, which runs on across timer wakes and restarts at a cold boot.
+void storeTrackPoints(char track, const TrackPoint *points, uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    FlashTrackRecord record;
+    record.ms = points[i].ms;
+    record.value = points[i].value;
+    record.track = track;
+    record.valid = points[i].valid;
+    flashLog.append(FLASH_RECORD_TRACK_POINT, &record, sizeof(record));
+
+    USBSerial.print("P,");
+    USBSerial.print(track);
+    USBSerial.print(",");
+    USBSerial.print(points[i].ms);
+    USBSerial.print(",");
+    if (points[i].valid) USBSerial.print(points[i].value, 1);
+    USBSerial.println();
+  }
+}
+
+// Snapshot the estimators, then deep sleep for the given time
+void sleepWithCheckpoint(uint32_t seconds) {
+  memoryPlanRelease();  // the NVS copy allocates; nothing runs after this
+  checkpointCapture(checkpointEngines, &checkpoint);
+  checkpoint.ledBrightness = ledBrightness;
+  checkpoint.sleepSeconds = seconds;
+  checkpoint.trackMs = trackClockMs + millis() + seconds * 1000;
+  checkpointSave(&checkpoint);
+  TrackPoint points[2];
+  storeTrackPoints('H', points, hrTrack.flush(points));
+  storeTrackPoints('S', points, spo2Track.flush(points));
+
+  DLOG(SLEEPING, seconds);
+  USBSerial.flush();
+  particleSensor.shutDown();
+  esp_sleep_enable_timer_wakeup((uint64_t)seconds * 1000000ULL);
+  esp_deep_sleep_start();
+}
 
 void setup() {
   USBSerial.begin(BAUD_RATE);
   while (!USBSerial);
   delay(SHORT_DELAY);
 
-  USBSerial.println("Debug: Before Wire.begin()");
+  logBegin(USBSerial);
+
+  DLOG(WIRE_BEFORE);
   Wire.begin(SDA, SCL);
   Wire.setClock(I2C_SPEED);
-  USBSerial.println("Debug: After Wire.begin()");
+  DLOG(WIRE_AFTER);
 
-  USBSerial.println("Debug: Attempting sensor init");
+  DLOG(SENSOR_PROBE);
   if (!particleSensor.begin(Wire, I2C_SPEED)) {
-    USBSerial.println("Error: MAX30102 init failed. Check wiring/power/address (0x57).");
+    DLOG(SENSOR_INIT_FAILED);
     while (1);
   }
-  USBSerial.println("Sensor initialized!");
+  DLOG(SENSOR_READY);
+
+  // LED setting and baselines from before deep sleep, if there is a checkpoint
+  restored = checkpointLoad(&checkpoint);
 
   // Sensor config (wrist-optimized)
-  byte ledBrightness = 80;
+  if (restored) ledBrightness = checkpoint.ledBrightness;
   byte sampleAverage = 16;  // High for raised noise
-  byte ledMode = 2;         // Red + IR
-  int sampleRate = 100;     // Hz
+  byte ledMode = (PPG_CHANNELS >= 3 || AMBIENT_CANCEL) ? 3 : 2;  // Red + IR (+ green or LED-off slot)
+  int sampleRate = SAMPLE_RATE;
   int pulseWidth = 411;     // Max SNR
   int adcRange = 8192;
 
   particleSensor.setup(ledBrightness, sampleAverage, ledMode, sampleRate, pulseWidth, adcRange);
-  USBSerial.println("Sensor configured. Place on skin for PPG data.");
+#if AMBIENT_CANCEL
+  particleSensor.setPulseAmplitudeGreen(0);  // slot 3 LED off: ambient only
+#endif
+  contact.begin(&particleSensor, ledMode, ledBrightness, AMBIENT_CANCEL ? 0 : ledBrightness, LOW_SIGNAL_IR,
+                CONTACT_LOSS_SAMPLES);  // starts searching on the pilot LED
+  DLOG(SENSOR_CONFIGURED);
+
+  batchPool.begin();
+  sampleRing.begin(&batchPool);
+  hrBank.begin(SAMPLE_RATE, GOERTZEL_START_BPM, GOERTZEL_STEP_BPM, GOERTZEL_BINS);
+  spectrumBank.begin(SAMPLE_RATE, (GOERTZEL_MIN_BPM + GOERTZEL_MAX_BPM) / 2, TRACK_STEP_BPM, TRACK_BINS, TRACK_TAU_SEC);
+  hrTracker.begin(TRACK_BINS);
+  DLOG(TRACKER_MEMORY, sizeof(hrTracker) + sizeof(spectrumBank));
+  autocorrHr.begin(&sampleRing, SAMPLE_RATE);
+  regressionSpo2.begin(SAMPLE_RATE);
+  nnHr.begin(&sampleRing);
+  morphology.begin(SAMPLE_RATE);
+  templateDetector.begin(&morphology, SAMPLE_RATE);
+
+  CaptureConfig captureConfig;
+  captureConfig.triggers = CAPTURE_TRIGGER_SPO2_DROP | CAPTURE_TRIGGER_HR_INVALID | CAPTURE_TRIGGER_LOW_SIGNAL;
+  captureConfig.preSeconds = CAPTURE_PRE_SEC;
+  captureConfig.postSeconds = CAPTURE_POST_SEC;
+  captureConfig.spo2Drop = 3;        // desaturation
+  captureConfig.invalidHrHops = 8;   // 2 s without HR
+  captureConfig.lowSignalIr = LOW_SIGNAL_IR;
+  capture.begin(captureConfig);
+  multiWindow.begin(SAMPLE_RATE);
+  fusion.begin();
+  TelemetryConfig telemetryConfig;
+  telemetryConfig.hrDeadband = TELEMETRY_HR_DEADBAND;
+  telemetryConfig.spo2Deadband = TELEMETRY_SPO2_DEADBAND;
+  telemetryConfig.minIntervalMs = TELEMETRY_MIN_MS;
+  telemetryConfig.keepAliveMs = TELEMETRY_KEEPALIVE_MS;
+  telemetry.begin(telemetryConfig);
+  hrTrack.begin(STORE_HR_DEVIATION, STORE_MAX_SPAN_MS);
+  spo2Track.begin(STORE_SPO2_DEVIATION, STORE_MAX_SPAN_MS);
+  if (flashLog.begin(FLASH_LOG_PARTITION)) {
+    DLOG(FLASH_LOG_RECOVERED, flashLog.recoveryMicros(), flashLog.recoveredRecords(),
+         flashLog.recoveredTorn() ? "; torn write skipped" : "", flashLog.nextSeq());
+    FlashBootRecord boot;
+    boot.sleptSeconds = restored && !(checkpoint.flags & CHECKPOINT_FROM_NVS) ? checkpoint.sleepSeconds : 0;
+    flashLog.append(FLASH_RECORD_BOOT, &boot, sizeof(boot));
+  } else {
+    DLOG(FLASH_LOG_MISSING);
+  }
+  if (restored) checkpointRestore(checkpointEngines, checkpoint, SAMPLE_RATE / HOP_SIZE);
+  if (restored && !(checkpoint.flags & CHECKPOINT_FROM_NVS)) trackClockMs = checkpoint.trackMs;
+  if (!restored) {
+    DLOG(CHECKPOINT_NONE);
+  } else if (checkpoint.flags & CHECKPOINT_FROM_NVS) {
+    DLOG(CHECKPOINT_RESTORED_NVS);
+  } else {
+    DLOG(CHECKPOINT_RESTORED);
+  }
+  if (nnSelfTest()) {
+    DLOG(NN_KERNELS_MATCH, NN_USE_PIE ? "PIE" : "portable", NnHR::memoryBytes());
+  } else {
+    DLOG(NN_KERNEL_MISMATCH, NN_USE_PIE ? "PIE" : "portable", NnHR::memoryBytes());
+  }
+#if FAST_MATH_BENCH
+  FastMathBench bench[FAST_MATH_BENCH_COUNT];
+  fastMathBenchmark(bench);
+  for (uint8_t i = 0; i < FAST_MATH_BENCH_COUNT; i++)
+    DLOG(FAST_MATH_BENCH, bench[i].name, bench[i].fastCycles, bench[i].libmCycles, bench[i].maxError * 1e6f);
+#endif
+#if NN_BENCH
+  uint32_t nnCycles = nnBenchmark();
+  DLOG(NN_BENCH, nnCycles, nnCycles / ESP.getCpuFreqMHz(), (uint32_t)NnHR::memoryBytes());
+#endif
+#if BATCH_POOL_BENCH
+  BatchPoolBench poolBench;
+  batchPoolBenchmark(batchPool, &poolBench);
+  DLOG(BATCH_POOL_BENCH, LogValue(poolBench.soloCycles, 0), LogValue(poolBench.contendedCycles, 0), poolBench.exhausted,
+       poolBench.corrupted, poolBench.leaked ? ", blocks leaked" : "");
+#endif
 
   // Init display
   if (!gfx->begin()) {
-    USBSerial.println("Display init failed!");
+    DLOG(DISPLAY_INIT_FAILED);
     while (1);
   }
   gfx->fillScreen(BLACK);
   pinMode(LCD_BL, OUTPUT);
   digitalWrite(LCD_BL, HIGH);
-  USBSerial.println("Display ready.");
+  DLOG(DISPLAY_READY);
+
+#if PROFILE_ENABLE
+  if (profiler.begin(PROFILE_HZ)) {
+    DLOG(PROFILER_RUNNING);
+  } else {
+    DLOG(PROFILER_FAILED);
+  }
+#endif
+#if PROFILE_TRACE
+  profilePrintStages(USBSerial);
+#endif
+
+  PIPELINE_OBJECTS(MEMORY_PLAN_REPORT)
+  DLOG(MEMORY_PLAN, (uint32_t)pipelineBytes, (uint32_t)MEMORY_BUDGET_BYTES, (uint32_t)NnHR::memoryBytes(),
+       ESP.getFreeHeap());
+  memoryPlanSeal();
+}
+
+// Per-sample engine updates, timed separately for the cost prints.
+// HR engines read PPG_HR_CHANNEL (green when fitted), SpO2 needs red/IR.
+void feedEngines(const uint32_t *sample) {
+  uint32_t red = sample[CH_RED];
+  uint32_t ir = sample[CH_IR];
+  uint32_t pulse = sample[PPG_HR_CHANNEL];
+  unsigned long t0 = micros();
+  hrBank.addSample(pulse);
+  unsigned long t1 = micros();
+  spectrumBank.addSample(pulse);
+  unsigned long t2 = micros();
+  regressionSpo2.addSample(red, ir);
+  unsigned long t3 = micros();
+  bool beat = morphology.addSample(pulse);
+  unsigned long t4 = micros();
+  multiWindow.addSample(regressionSpo2);  // reuses the filtered red/IR
+  unsigned long t5 = micros();
+  capture.addSample(red, ir);
+  goertzelMicros += t1 - t0;
+  trackerMicros += t2 - t1;
+  regressionMicros += t3 - t2;
+  multiWindowMicros += t5 - t4;
+  if (beat) {
+    morphMicros += t4 - t3;
+    morphBeats++;
+  }
+}
+
+// Drain up to want samples (one batch worth) from the sensor FIFO straight
+// into the sample ring's open block. Stops after the sample on which contact
+// is lost; that one is still kept. Returns the samples read.
+uint16_t readBatch(int want) {
+  uint16_t count = 0;
+  while (count < BATCH_SAMPLES && count < want) {
+    uint32_t *sample = sampleRing.claim();
+    if (!sample) {
+      DLOG(BATCH_POOL_EMPTY, batchPool.exhausted());
+      break;
+    }
+    while (!particleSensor.available()) particleSensor.check();
+    sample[CH_RED] = particleSensor.getRed();
+    sample[CH_IR] = particleSensor.getIR();
+#if PPG_CHANNELS >= 3
+    sample[CH_GREEN] = particleSensor.getGreen();
+#endif
+#if AMBIENT_CANCEL
+    // Subtract the LED-off slot in place, before anything else sees the sample
+    ambient = particleSensor.getGreen();
+    cancelAmbient(sample, ambient);
+#endif
+    particleSensor.nextSample();
+    sampleRing.commit();
+    count++;
+    if (!contact.addSample(sample[CH_IR])) break;
+  }
+  return count;
+}
+
+// Consumers on the loop task read the samples in place in the ring; one
+// that keeps them past the hop retains sampleRing.batch(n) with the pool
+void consumeBatch(uint32_t first, uint16_t count) {
+  for (uint32_t n = first; n < first + count; n++) feedEngines(sampleRing.sample(n));
+}
+
+// Quality of a 0..1 score on the fusion's 1..255 scale
+uint8_t toQuality(float score) {
+  if (score <= 0) return 0;
+  return score >= 1 ? 255 : (uint8_t)(score * 255);
+}
+
+// Feed every engine that produced an estimate this hop into the fusion.
+// Engines without their own score get a fixed quality by how well they hold up.
+void fuseEstimates() {
+  fusion.predict();
+  if (validHeartRate) fusion.addHeartRate(heartRate, 80);
+  if (validGoertzelHeartRate) fusion.addHeartRate(goertzelHeartRate, 100);
+  if (validTrackedHeartRate) fusion.addHeartRate(trackedHeartRate, 180);
+  if (validAutocorrHeartRate) fusion.addHeartRate(autocorrHeartRate, toQuality(autocorrHr.quality()));
+#if NN_WEIGHTS_TRAINED
+  if (validNnHeartRate) fusion.addHeartRate(nnHeartRate, 150);
+#endif
+  if (validTemplateHeartRate) fusion.addHeartRate(templateHeartRate, toQuality(templateDetector.lastCorrelation()));
+  if (logEstimate.validHeartRate) fusion.addHeartRate(logEstimate.heartRate, toQuality(logEstimate.regularity));
+
+  if (validSpo2) fusion.addSpo2(spo2, 80);
+  if (validRegSpo2) fusion.addSpo2(regSpo2, toQuality(regressionSpo2.confidence()));
+  if (logEstimate.validSpo2) fusion.addSpo2(logEstimate.spo2, toQuality(logEstimate.confidence));
+
+  validFusedHeartRate = fusion.heartRate(&fusedHeartRate);
+  validFusedSpo2 = fusion.oxygenSaturation(&fusedSpo2);
 }
 
 void loop() {
   startTime = millis();  // Start timing
+  profileEnter(PROFILE_STAGE_ACQUIRE);
 
-  // Initial full buffer fill (only once)
-  static bool firstRun = true;
-  if (firstRun) {
-    for (int i = 0; i < bufferSize; i++) {
-      while (!particleSensor.available()) particleSensor.check();
-      redBuffer[i] = particleSensor.getRed();
-      irBuffer[i] = particleSensor.getIR();
-      particleSensor.nextSample();
+  // Off the skin only the pilot LED runs; skip acquisition and compute
+  if (!contact.onSkin()) {
+    if (!contact.poll()) {
+      profileEnter(PROFILE_STAGE_IDLE);
+      delay(250);
+      return;
     }
+    DLOG(CONTACT_ON);
+    firstRun = true;
+  }
+  goertzelMicros = 0;
+  trackerMicros = 0;
+  autocorrMicros = 0;
+  regressionMicros = 0;
+  morphMicros = 0;
+  morphBeats = 0;
+  multiWindowMicros = 0;
+
+  // Initial full buffer fill (on contact), then HOP_SIZE new samples per cycle
+  int newSamples = firstRun ? bufferSize : HOP_SIZE;
+  unsigned long pipelineStart = micros();
+  int remaining = newSamples;
+  while (remaining > 0 && contact.onSkin()) {
+    uint32_t first = sampleRing.count();
+    uint16_t count = readBatch(remaining);
+    if (!count) break;
+    remaining -= count;
+    consumeBatch(first, count);
+  }
+  if (!contact.onSkin()) {
+    DLOG(CONTACT_LOST);
+    gfx->fillRect(10, 10, 200, 75, BLACK);
+    gfx->setCursor(10, 10);
+    gfx->setTextSize(2);
+    gfx->println("No contact");
+    return;
+  }
+  unsigned long pipelineMicros = micros() - pipelineStart;
+  if (firstRun) {
     firstRun = false;
-    USBSerial.println("Initial buffer filled.");
-  } else {
-    // Sliding window: Shift and add 25 new samples (~0.25 sec update)
-    for (int i = 0; i < 25; i++) {
-      // Shift buffers left
-      memmove(redBuffer, redBuffer + 1, (bufferSize - 1) * sizeof(uint32_t));
-      memmove(irBuffer, irBuffer + 1, (bufferSize - 1) * sizeof(uint32_t));
-
-      // Add new sample
-      while (!particleSensor.available()) particleSensor.check();
-      redBuffer[bufferSize - 1] = particleSensor.getRed();
-      irBuffer[bufferSize - 1] = particleSensor.getIR();
-      particleSensor.nextSample();
-    }
+    DLOG(BUFFER_FILLED);
   }
 
+  // Sliding window for the Maxim routine, copied out of the ring
+  sampleRing.copyLatest(redBuffer, irBuffer, bufferSize);
+
+  // Autocorrelation lags catch up on the new samples (O(lags) per sample)
+  profileEnter(PROFILE_STAGE_AUTOCORR);
+  unsigned long t0 = micros();
+  autocorrHr.update();
+  autocorrHr.estimate(&autocorrHeartRate, &validAutocorrHeartRate);
+  autocorrMicros = micros() - t0;
+
   // Calc HR/SpO2
+  profileEnter(PROFILE_STAGE_MAXIM);
   maxim_heart_rate_and_oxygen_saturation(irBuffer, bufferSize, redBuffer, &spo2, &validSpo2, &heartRate, &validHeartRate);
 
+  // Goertzel HR; seed the bank from the Maxim estimate until it locks
+  profileEnter(PROFILE_STAGE_GOERTZEL);
+  t0 = micros();
+  hrBank.estimate(&goertzelHeartRate, &validGoertzelHeartRate);
+  goertzelMicros += micros() - t0;
+  if (!validGoertzelHeartRate && validHeartRate) hrBank.recenter(heartRate);
+
+  // One spectrogram column per hop into the Viterbi tracker
+  profileEnter(PROFILE_STAGE_TRACKER);
+  t0 = micros();
+  hrTracker.addColumn(spectrumBank);
+  hrTracker.estimate(&trackedHeartRate, &validTrackedHeartRate);
+  trackerMicros += micros() - t0;
+
+  // Regression SpO2 gives a value every hop, with its fit confidence
+  profileEnter(PROFILE_STAGE_REGRESSION);
+  t0 = micros();
+  regressionSpo2.estimate(&regSpo2, &validRegSpo2);
+  regressionMicros += micros() - t0;
+
+#if NN_WEIGHTS_TRAINED
+  // CNN inference over the last NN_WINDOW samples (no accelerometer fitted)
+  profileEnter(PROFILE_STAGE_NN);
+  t0 = micros();
+  nnHr.estimate(&nnHeartRate, &validNnHeartRate);
+  nnMicros = micros() - t0;
+#endif
+
+  // Template matching over the filtered pulse the morphology stage kept
+  profileEnter(PROFILE_STAGE_TEMPLATE);
+  t0 = micros();
+  templateDetector.update();
+  templateDetector.estimate(&templateHeartRate, &validTemplateHeartRate);
+  templateMicros = micros() - t0;
+
   // Timing log
+  profileEnter(PROFILE_STAGE_OUTPUT);
   unsigned long calcTime = millis() - startTime;
-  USBSerial.print("Cycle time: ");
-  USBSerial.print(calcTime);
-  USBSerial.println(" ms");
+  DLOG(CYCLE_TIME, calcTime);
+
+  // Acquisition + per-sample engine work, to compare channel profiles
+  DLOG(PIPELINE, pipelineMicros / (float)newSamples, PPG_CHANNELS);
 
   // Stream raw sample
-  USBSerial.print("Raw PPG - IR: ");
-  USBSerial.print(irBuffer[bufferSize - 1]);
-  USBSerial.print(", Red: ");
-  USBSerial.println(redBuffer[bufferSize - 1]);
+  DLOG(RAW_SAMPLE, irBuffer[bufferSize - 1], redBuffer[bufferSize - 1]);
+#if AMBIENT_CANCEL
+  DLOG(AMBIENT, ambient);
+#endif
 
   // Output metrics to serial
-  USBSerial.print(validHeartRate ? "HR: " + String(heartRate) + " bpm" : "Invalid HR");
-  USBSerial.print(", ");
-  USBSerial.println(validSpo2 ? "SpO2: " + String(spo2) + "%" : "Invalid SpO2");
+  DLOG(MAXIM, logValid(heartRate, validHeartRate), logValid(spo2, validSpo2));
+
+  // Goertzel HR next to the Maxim one for comparison, with cost per sample
+  DLOG(GOERTZEL, logValid(goertzelHeartRate, validGoertzelHeartRate), goertzelMicros / (float)HOP_SIZE);
+  DLOG(TRACKED, logValid(trackedHeartRate, validTrackedHeartRate), trackerMicros);
+  DLOG(AUTOCORR, logValid(autocorrHr.bpm(), validAutocorrHeartRate, 1), autocorrHr.window(), autocorrMicros);
+  DLOG(REGRESSION, logValid(regSpo2, validRegSpo2), LogValue(regressionSpo2.ratio(), 3), regressionSpo2.confidence(),
+       regressionMicros);
+#if NN_WEIGHTS_TRAINED
+  DLOG(NN, logValid(nnHeartRate, validNnHeartRate), nnMicros);
+#endif
+
+  // Per-beat morphology records queued since the last cycle
+  BeatFeatures beat;
+  while (morphology.pop(&beat)) {
+    multiWindow.addBeat(beat);
+    DLOG(BEAT, (int32_t)beat.amplitude, beat.ibiMs, beat.riseMs, beat.widthMs, beat.notchMs, beat.notchRatio);
+  }
+  if (morphBeats) {
+    DLOG(MORPH_COST, morphMicros / morphBeats);
+  }
+  // Both windows read the same blocks and beats
+  profileEnter(PROFILE_STAGE_WINDOWS);
+  t0 = micros();
+  multiWindow.estimate(DISPLAY_WINDOW_SEC, &displayEstimate);
+  multiWindow.estimate(LOG_WINDOW_SEC, &logEstimate);
+  multiWindowMicros += micros() - t0;
+  profileEnter(PROFILE_STAGE_OUTPUT);
+  DLOG(WINDOWS, DISPLAY_WINDOW_SEC, logValid(displayEstimate.heartRate, displayEstimate.validHeartRate),
+       logValid(displayEstimate.spo2, displayEstimate.validSpo2), LOG_WINDOW_SEC,
+       logValid(logEstimate.heartRate, logEstimate.validHeartRate), logValid(logEstimate.spo2, logEstimate.validSpo2),
+       multiWindowMicros);
+
+  DLOG(TEMPLATE, logValid(templateHeartRate, validTemplateHeartRate), templateDetector.beats(),
+       templateDetector.lastCorrelation(), templateMicros / (float)HOP_SIZE);
+
+  // Fused vitals coast through brief dropouts of the individual engines
+  profileEnter(PROFILE_STAGE_FUSION);
+  t0 = micros();
+  fuseEstimates();
+  fusionMicros = micros() - t0;
+  profileEnter(PROFILE_STAGE_OUTPUT);
+  DLOG(FUSED, logValid(fusedHeartRate, validFusedHeartRate), LogValue(fusion.heartRateState().variance() / (float)KALMAN_ONE, 1),
+       logValid(fusedSpo2, validFusedSpo2), LogValue(fusion.spo2State().variance() / (float)KALMAN_ONE, 1), fusionMicros);
+  telemetry.update(millis(), fusedHeartRate, validFusedHeartRate, fusedSpo2, validFusedSpo2, USBSerial);
+
+  // Compressed tracks for long-term storage
+  profileEnter(PROFILE_STAGE_STORE);
+  TrackPoint points[2];
+  uint32_t nowMs = trackClockMs + millis();  // millis() restarts on every wake
+  t0 = micros();
+  uint8_t hrPoints = hrTrack.add(nowMs, fusedHeartRate, validFusedHeartRate, points);
+  trackMicros = micros() - t0;
+  storeTrackPoints('H', points, hrPoints);
+  t0 = micros();
+  uint8_t spo2Points = spo2Track.add(nowMs, fusedSpo2, validFusedSpo2, points);
+  trackMicros += micros() - t0;
+  storeTrackPoints('S', points, spo2Points);
+  uint32_t archived = hrTrack.archived() + spo2Track.archived();
+  float compression = archived ? hrTrack.inputs() * 2 / (float)archived : 0;  // 0 until the first point is archived
+  DLOG(TRACK_COMPRESSION, LogValue(compression, 1), trackMicros);
+  profileEnter(PROFILE_STAGE_OUTPUT);
+  if (!validAtMs && validFusedHeartRate && validFusedSpo2) {
+    validAtMs = millis();
+    DLOG(TIME_TO_VALID, validAtMs, restored ? "restored" : "cold");
+  }
 
   // Display metrics (update text without full clear for speed)
-  gfx->fillRect(10, 10, 200, 60, BLACK);  // Clear small area
+  gfx->fillRect(10, 10, 200, 75, BLACK);  // Clear small area
   gfx->setCursor(10, 10);
   gfx->setTextColor(RED);
   gfx->setTextSize(2);
-  gfx->println(validHeartRate ? "HR: " + String(heartRate) : "No HR");
+  if (validFusedHeartRate) {
+    gfx->print("HR: ");
+    gfx->println(fusedHeartRate);
+  } else {
+    gfx->println("No HR");
+  }
   gfx->setCursor(10, 40);
-  gfx->println(validSpo2 ? "SpO2: " + String(spo2) : "No SpO2");
+  if (validFusedSpo2) {
+    gfx->print("SpO2: ");
+    gfx->println(fusedSpo2);
+  } else {
+    gfx->println("No SpO2");
+  }
+
+  // Fast window underneath, follows changes the fused values smooth over
+  gfx->setCursor(10, 70);
+  gfx->setTextSize(1);
+  gfx->print(DISPLAY_WINDOW_SEC);
+  gfx->print(" s: ");
+  if (displayEstimate.validHeartRate) {
+    gfx->print(displayEstimate.heartRate);
+  } else {
+    gfx->print("--");
+  }
+  gfx->print(" bpm ");
+  if (displayEstimate.validSpo2) {
+    gfx->print(displayEstimate.spo2);
+  } else {
+    gfx->print("--");
+  }
+  gfx->println(" %");
+
+  if (irBuffer[bufferSize - 1] < LOW_SIGNAL_IR) {
+    DLOG(LOW_SIGNAL);
+  }
+
+  // Raw capture: check triggers, then drain a finished capture a bit at a time
+  capture.checkVitals(spo2, validSpo2, validHeartRate, irBuffer[bufferSize - 1]);
+  capture.exportTo(USBSerial, CAPTURE_LINES_PER_CYCLE);
+
+#if PROFILE_ENABLE
+  profiler.dumpTo(USBSerial, PROFILE_LINES_PER_CYCLE);
+  DLOG(PROFILER_STATS, LogValue(profiler.isrCycles(), 0), profiler.dropped());
+#endif
+#if PROFILE_TRACE
+  loopTrace.dumpTo(USBSerial, TRACE_LINES_PER_CYCLE);
+#endif
+
+#if DUTY_CYCLE_SEC > 0
+  dutyValidHops = validFusedHeartRate && validFusedSpo2 ? dutyValidHops + 1 : 0;
+  if (dutyValidHops >= DUTY_CYCLE_HOPS && !capture.busy()) sleepWithCheckpoint(DUTY_CYCLE_SEC);
+#endif
 
-  if (irBuffer[bufferSize - 1] < 50000) {
-    USBSerial.println("Low signal - Check contact");
+  DLOG(LOG_STATS, logEvents(), logEvents() ? logBytes() / (float)logEvents() : 0.0f);
+  if (memoryPlanAllocations() != reportedAllocations) {
+    reportedAllocations = memoryPlanAllocations();
+    DLOG(HEAP_AFTER_SETUP, reportedAllocations, memoryPlanAllocatedBytes());
   }
 
+  profileEnter(PROFILE_STAGE_IDLE);
   delay(250);  // Shorter delay for faster cycles
 }
\ No newline at end of file
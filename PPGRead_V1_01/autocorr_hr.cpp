@@ -0,0 +1,102 @@
+#include "autocorr_hr.h"
+
+#define AUTOCORR_MIN_PEAK 0.5f     // normalized autocorrelation at the HR lag
+#define AUTOCORR_FIRST_PEAK 0.9f   // prefer the shortest lag within this of the max
+#define AUTOCORR_GROW 1.25f        // window growth per hop without an estimate
+#define AUTOCORR_HYSTERESIS 0.1f   // relative change needed to resize
+
+void AutocorrHR::begin(const SampleRing *r, float fs) {
+  ring = r;
+  sampleRate = fs;
+  origin = next = ring->count();
+  added = 0;
+  windowLen = AUTOCORR_MAX_WINDOW / 2;
+  inWindow = 0;
+  memset(lagSum, 0, sizeof(lagSum));
+  memset(prefix, 0, sizeof(prefix));
+  lastBpm = 0;
+  lastPeak = 0;
+}
+
+void AutocorrHR::addProducts(uint32_t n, int sign) {
+  int64_t x = ring->hr(n);
+  lagSum[0] += sign * x * x;
+  for (uint16_t lag = AUTOCORR_MIN_LAG - 1; lag <= AUTOCORR_MAX_LAG; lag++)
+    lagSum[lag] += sign * x * (int64_t)ring->hr(n - lag);
+}
+
+void AutocorrHR::update() {
+  while (next != ring->count()) {
+    uint32_t n = next++;
+    prefix[n & SAMPLE_RING_MASK] = prefix[(n - 1) & SAMPLE_RING_MASK] + ring->hr(n);
+    if (n - origin < AUTOCORR_MAX_LAG) continue;  // lagged samples not there yet
+    added++;
+    addProducts(n, 1);
+    if (++inWindow > windowLen) {
+      addProducts(n - windowLen, -1);
+      inWindow--;
+    }
+  }
+}
+
+// Only the samples crossing the old edge are touched
+void AutocorrHR::setWindow(uint16_t len) {
+  if (len < AUTOCORR_MIN_WINDOW) len = AUTOCORR_MIN_WINDOW;
+  if (len > AUTOCORR_MAX_WINDOW) len = AUTOCORR_MAX_WINDOW;
+  uint32_t newest = next - 1;
+  uint16_t have = inWindow;
+  uint16_t want = len < added ? len : added;
+  for (; have < want; have++) addProducts(newest - have, 1);
+  for (; have > want; have--) addProducts(newest - have + 1, -1);
+  inWindow = have;
+  windowLen = len;
+}
+
+void AutocorrHR::adaptWindow(bool valid) {
+  float target = valid ? AUTOCORR_TARGET_BEATS * 60.0f * sampleRate / lastBpm : windowLen * AUTOCORR_GROW;
+  if (fabsf(target - windowLen) > AUTOCORR_HYSTERESIS * windowLen) setWindow((uint16_t)target);
+}
+
+bool AutocorrHR::estimate(int32_t *heartRate, int8_t *validHeartRate) {
+  *validHeartRate = 0;
+  lastPeak = 0;
+  if (inWindow < windowLen) return false;
+
+  // Autocovariance normalized by lag 0. Each lag uses the mean of its own
+  // lagged window, so baseline offsets between the two windows cancel.
+  uint32_t n = next - 1;
+  double mean = (double)windowSum(n) / windowLen;
+  double c0 = (double)lagSum[0] / windowLen - mean * mean;
+  if (c0 <= 0) return false;
+  float r[AUTOCORR_MAX_LAG + 1];
+  float peak = -1;
+  for (uint16_t lag = AUTOCORR_MIN_LAG - 1; lag <= AUTOCORR_MAX_LAG; lag++) {
+    double lagMean = (double)windowSum(n - lag) / windowLen;
+    r[lag] = ((double)lagSum[lag] / windowLen - mean * lagMean) / c0;
+    if (lag >= AUTOCORR_MIN_LAG && r[lag] > peak) peak = r[lag];
+  }
+
+  // Shortest local maximum close to the global one, to avoid multiples of the period
+  uint16_t best = 0;
+  for (uint16_t lag = AUTOCORR_MIN_LAG; lag < AUTOCORR_MAX_LAG && peak >= AUTOCORR_MIN_PEAK; lag++) {
+    if (r[lag] >= AUTOCORR_FIRST_PEAK * peak && r[lag] >= r[lag - 1] && r[lag] >= r[lag + 1]) {
+      best = lag;
+      break;
+    }
+  }
+  if (best == 0) {  // no clear peak, or it sits on the lag range edge
+    adaptWindow(false);
+    return false;
+  }
+
+  float den = r[best - 1] - 2.0f * r[best] + r[best + 1];
+  float lag = best;
+  if (den < 0) lag += 0.5f * (r[best - 1] - r[best + 1]) / den;
+
+  lastBpm = 60.0f * sampleRate / lag;
+  lastPeak = r[best];
+  *heartRate = (int32_t)(lastBpm + 0.5f);
+  *validHeartRate = 1;
+  adaptWindow(true);
+  return true;
+}
@@ -0,0 +1,52 @@
+#ifndef AUTOCORR_HR_H
+#define AUTOCORR_HR_H
+
+#include <Arduino.h>
+#include "sample_ring.h"
+
+// Incremental autocorrelation HR engine.
+// Lag products are kept as exact integer sums and updated as samples enter
+// and leave the window, so each sample costs O(lags) instead of the naive
+// O(window * lags) per estimate. The peak lag is refined with a parabola
+// for sub-bpm resolution.
+//
+// The window length adapts to cover AUTOCORR_TARGET_BEATS beats at the
+// current HR, and grows while no estimate is found. Resizing only adds or
+// removes the products of the samples crossing the window edge; window sums
+// for any length come from a prefix-sum ring.
+
+#define AUTOCORR_MIN_WINDOW 150  // samples (1.5 s)
+#define AUTOCORR_MAX_WINDOW 600  // samples (6 s), preallocated through the ring
+#define AUTOCORR_MIN_LAG 30      // 200 bpm at 100 Hz
+#define AUTOCORR_MAX_LAG 150     // 40 bpm at 100 Hz
+#define AUTOCORR_TARGET_BEATS 4
+
+class AutocorrHR {
+public:
+  void begin(const SampleRing *ring, float sampleRate);
+  void update();  // consume samples pushed to the ring since the last call
+  bool estimate(int32_t *heartRate, int8_t *validHeartRate);
+  void setWindow(uint16_t len);
+  uint16_t window() const { return windowLen; }
+  float bpm() const { return lastBpm; }  // refined, unrounded estimate
+  float quality() const { return lastPeak; }  // normalized autocorrelation at the HR lag
+
+private:
+  void addProducts(uint32_t n, int sign);
+  void adaptWindow(bool valid);
+  int64_t windowSum(uint32_t end) const { return prefix[end & SAMPLE_RING_MASK] - prefix[(end - windowLen) & SAMPLE_RING_MASK]; }
+
+  const SampleRing *ring;
+  float sampleRate;
+  uint32_t origin;     // first ring index used, products start at origin + max lag
+  uint32_t next;       // next ring index to consume
+  uint32_t added;      // samples with full lag history seen so far
+  uint16_t windowLen;  // target window length
+  uint16_t inWindow;   // samples currently summed (window fills from empty)
+  int64_t lagSum[AUTOCORR_MAX_LAG + 1];  // sum of x[n] * x[n - L] over the window
+  int64_t prefix[SAMPLE_RING_SIZE];      // running sum of x, by ring index
+  float lastBpm;
+  float lastPeak;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "batch_pool.h"
+
+#define BATCH_EMPTY 0xFFFF
+#define BATCH_TAG_ONE 0x10000
+
+void BatchPool::begin() {
+  for (uint16_t i = 0; i < BATCH_POOL_BLOCKS; i++) {
+    refs[i].store(0, std::memory_order_relaxed);
+    next[i].store(i + 1 < BATCH_POOL_BLOCKS ? i + 1 : BATCH_EMPTY, std::memory_order_relaxed);
+  }
+  failed.store(0, std::memory_order_relaxed);
+  head.store(0, std::memory_order_release);  // tag 0, block 0 on top
+}
+
+// Pop: a stale next[] read is harmless, the tag makes the CAS fail
+SampleBatch *BatchPool::acquire() {
+  uint32_t old = head.load(std::memory_order_acquire);
+  for (;;) {
+    uint16_t top = old & 0xFFFF;
+    if (top == BATCH_EMPTY) {
+      failed.fetch_add(1, std::memory_order_relaxed);
+      return NULL;
+    }
+    uint32_t popped = (old & ~0xFFFFu) | next[top].load(std::memory_order_relaxed);
+    if (head.compare_exchange_weak(old, popped, std::memory_order_acquire, std::memory_order_acquire)) {
+      refs[top].store(1, std::memory_order_relaxed);
+      return &blocks[top];
+    }
+  }
+}
+
+void BatchPool::retain(const SampleBatch *batch) { refs[indexOf(batch)].fetch_add(1, std::memory_order_relaxed); }
+
+// The last reader's loads must finish before the block can be handed out
+void BatchPool::release(const SampleBatch *batch) {
+  uint16_t index = indexOf(batch);
+  if (refs[index].fetch_sub(1, std::memory_order_acq_rel) == 1) push(index);
+}
+
+void BatchPool::push(uint16_t index) {
+  uint32_t old = head.load(std::memory_order_relaxed);
+  for (;;) {
+    next[index].store(old & 0xFFFF, std::memory_order_relaxed);
+    uint32_t pushed = ((old & ~0xFFFFu) + BATCH_TAG_ONE) | index;
+    if (head.compare_exchange_weak(old, pushed, std::memory_order_release, std::memory_order_relaxed)) return;
+  }
+}
+
+uint16_t BatchPool::available() const {
+  uint16_t n = 0;
+  for (uint16_t i = 0; i < BATCH_POOL_BLOCKS; i++)
+    if (refs[i].load(std::memory_order_relaxed) == 0) n++;
+  return n;
+}
@@ -0,0 +1,68 @@
+#ifndef BATCH_POOL_H
+#define BATCH_POOL_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "ppg_channels.h"
+
+// Fixed pool of reference-counted sample batches.
+// The sample ring is built from these blocks: acquisition drains the FIFO
+// into the ring's open block once and every consumer reads that same block
+// through a const pointer. A consumer that keeps it past the hop (another
+// task, a deferred sink) takes its own reference, and the block goes back
+// to the pool when the last reference is released.
+//
+// The free list is a Treiber stack. Its head packs the top block index with
+// a generation tag bumped on every push, so a compare-and-swap can't be
+// fooled by a block popped and pushed back in between (ABA). Everything is
+// 32-bit atomics, lock-free on both S3 cores and from ISRs, and the pool
+// never touches the heap.
+
+#define BATCH_SAMPLES 32       // per batch; a hop (HOP_SIZE) fits in one
+#define BATCH_POOL_BLOCKS 36   // the sample ring's 32, the one it opens, 3 retained past a hop; at most 0xFFFE
+
+struct SampleBatch {
+  uint32_t firstIndex;  // sample ring index of samples[0]
+  uint16_t count;       // samples written so far
+  uint32_t samples[BATCH_SAMPLES][PPG_CHANNELS];  // as read from the FIFO
+};
+
+class BatchPool {
+public:
+  void begin();
+
+  // Writable batch holding one reference, or NULL when all are in use
+  SampleBatch *acquire();
+  void retain(const SampleBatch *batch);
+  void release(const SampleBatch *batch);
+
+  uint16_t available() const;  // free blocks; a snapshot under contention
+  uint32_t exhausted() const { return failed.load(std::memory_order_relaxed); }
+
+private:
+  uint16_t indexOf(const SampleBatch *batch) const { return (uint16_t)(batch - blocks); }
+  void push(uint16_t index);
+
+  SampleBatch blocks[BATCH_POOL_BLOCKS];
+  std::atomic<uint32_t> refs[BATCH_POOL_BLOCKS];
+  std::atomic<uint32_t> next[BATCH_POOL_BLOCKS];
+  std::atomic<uint32_t> head;  // tag << 16 | top index
+  std::atomic<uint32_t> failed;
+};
+
+// Two-core contention check (batch_pool_bench.cpp): a worker pinned to the
+// other core and the caller hammer the pool together; each holds a batch
+// across a short critical section and checks nobody else wrote to it
+// meanwhile. tests/batch_pool_contention_test.cpp does the same with host
+// threads.
+struct BatchPoolBench {
+  float soloCycles;       // acquire + release, one core
+  float contendedCycles;  // same, both cores running
+  uint32_t exhausted;     // acquires that found the pool empty
+  uint32_t corrupted;     // batches seen modified while held; must be 0
+  bool leaked;            // fewer free blocks afterwards than before
+};
+
+void batchPoolBenchmark(BatchPool &pool, BatchPoolBench *out);
+
+#endif
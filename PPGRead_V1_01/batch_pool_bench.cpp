@@ -0,0 +1,69 @@
+#include "batch_pool.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define BATCH_BENCH_ROUNDS 20000
+#define BATCH_BENCH_STACK 2048  // bytes, worker task
+
+namespace {
+
+struct BenchWorker {
+  BatchPool *pool;
+  std::atomic<bool> go, done;
+  uint32_t corrupted;
+};
+
+BenchWorker worker;
+StaticTask_t workerTask;
+StackType_t workerStack[BATCH_BENCH_STACK];
+
+// One round: acquire, stamp, share with a reader, check the stamp, release both
+uint32_t hammer(BatchPool &pool, uint32_t stamp) {
+  uint32_t corrupted = 0;
+  for (uint32_t i = 0; i < BATCH_BENCH_ROUNDS; i++) {
+    SampleBatch *batch = pool.acquire();
+    if (!batch) continue;
+    batch->firstIndex = stamp ^ i;
+    batch->samples[0][0] = stamp ^ i;
+    pool.retain(batch);
+    pool.release(batch);
+    if (batch->firstIndex != (stamp ^ i) || batch->samples[0][0] != (stamp ^ i)) corrupted++;
+    pool.release(batch);
+  }
+  return corrupted;
+}
+
+void workerMain(void *arg) {
+  (void)arg;
+  while (!worker.go.load(std::memory_order_acquire)) {}
+  worker.corrupted = hammer(*worker.pool, 0x80000000);
+  worker.done.store(true, std::memory_order_release);
+  vTaskDelete(NULL);
+}
+
+}  // namespace
+
+void batchPoolBenchmark(BatchPool &pool, BatchPoolBench *out) {
+  uint32_t failedBefore = pool.exhausted();
+  uint16_t freeBefore = pool.available();
+
+  uint32_t start = ESP.getCycleCount();
+  out->corrupted = hammer(pool, 0);
+  out->soloCycles = (ESP.getCycleCount() - start) / (float)BATCH_BENCH_ROUNDS;
+
+  // Static task, so the benchmark can run after the memory plan is sealed
+  worker.pool = &pool;
+  worker.go.store(false);
+  worker.done.store(false);
+  xTaskCreateStaticPinnedToCore(workerMain, "batchBench", BATCH_BENCH_STACK, NULL, 1, workerStack, &workerTask,
+                                1 - xPortGetCoreID());
+  worker.go.store(true, std::memory_order_release);
+  start = ESP.getCycleCount();
+  out->corrupted += hammer(pool, 0x40000000);
+  out->contendedCycles = (ESP.getCycleCount() - start) / (float)BATCH_BENCH_ROUNDS;
+  while (!worker.done.load(std::memory_order_acquire)) delay(1);
+
+  out->corrupted += worker.corrupted;
+  out->exhausted = pool.exhausted() - failedBefore;
+  out->leaked = pool.available() < freeBefore;
+}
@@ -0,0 +1,111 @@
+#include "checkpoint.h"
+#include "regression_spo2.h"
+#include "goertzel_hr.h"
+#include "pulse_morphology.h"
+#include "hr_tracker.h"
+#include "vitals_fusion.h"
+#include <Preferences.h>
+#include <esp_sleep.h>
+#include <stddef.h>
+
+#define CHECKPOINT_NVS_NAMESPACE "ppg"
+#define CHECKPOINT_NVS_KEY "ckpt"
+
+RTC_DATA_ATTR static EstimatorCheckpoint rtcCheckpoint;
+RTC_DATA_ATTR static uint32_t saveCount;
+
+// CRC-16/CCITT-FALSE
+uint16_t crc16(const uint8_t *data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  while (len--) {
+    crc ^= (uint16_t)*data++ << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+static bool checkpointValid(const EstimatorCheckpoint &cp) {
+  return cp.magic == CHECKPOINT_MAGIC && cp.version == CHECKPOINT_VERSION
+         && cp.crc == crc16((const uint8_t *)&cp, offsetof(EstimatorCheckpoint, crc));
+}
+
+void checkpointSave(EstimatorCheckpoint *cp) {
+  cp->magic = CHECKPOINT_MAGIC;
+  cp->version = CHECKPOINT_VERSION;
+  cp->flags &= ~CHECKPOINT_FROM_NVS;
+  cp->crc = crc16((const uint8_t *)cp, offsetof(EstimatorCheckpoint, crc));
+  rtcCheckpoint = *cp;
+
+  if (saveCount++ % CHECKPOINT_NVS_INTERVAL == 0) {
+    Preferences prefs;
+    prefs.begin(CHECKPOINT_NVS_NAMESPACE, false);
+    prefs.putBytes(CHECKPOINT_NVS_KEY, cp, sizeof(*cp));
+    prefs.end();
+  }
+}
+
+bool checkpointLoad(EstimatorCheckpoint *cp) {
+  // RTC memory also survives a reset, but only the timer wake returns from
+  // the sleep that saved it; the copy is used once either way
+  bool warm = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER && checkpointValid(rtcCheckpoint);
+  if (warm) *cp = rtcCheckpoint;
+  checkpointClear();
+  if (warm) return true;
+
+  // Cold boot: the NVS copy may be old, keep only what changes slowly
+  Preferences prefs;
+  prefs.begin(CHECKPOINT_NVS_NAMESPACE, true);
+  size_t got = prefs.getBytes(CHECKPOINT_NVS_KEY, cp, sizeof(*cp));
+  prefs.end();
+  if (got != sizeof(*cp) || !checkpointValid(*cp)) return false;
+  cp->flags = CHECKPOINT_FROM_NVS;
+  return true;
+}
+
+void checkpointClear() {
+  rtcCheckpoint.magic = 0;
+}
+
+void checkpointCapture(const CheckpointEngines &engines, EstimatorCheckpoint *cp) {
+  cp->flags = 0;
+  cp->redDc = engines.spo2->redDcLevel();
+  cp->irDc = engines.spo2->irDcLevel();
+  cp->pulseDc = engines.hrBank->dcLevel();
+  int32_t state, var;  // the struct is packed: no pointers into it
+  if (engines.fusion->heartRateState().getState(&state, &var)) {
+    cp->hrState = state;
+    cp->hrVar = var;
+    cp->flags |= CHECKPOINT_HAS_HR;
+  }
+  if (engines.fusion->spo2State().getState(&state, &var)) {
+    cp->spo2State = state;
+    cp->spo2Var = var;
+    cp->flags |= CHECKPOINT_HAS_SPO2;
+  }
+}
+
+// Baselines are always reused; the vitals only come from the RTC copy, with
+// the uncertainty grown by the hops slept so the first measurements can
+// still pull them. The Goertzel band is not moved to the old HR: centred on
+// its peak it takes longer to pass its peak test
+// (tests/checkpoint_warm_start_test.cpp), and it recentres on its first
+// estimate anyway.
+void checkpointRestore(const CheckpointEngines &engines, const EstimatorCheckpoint &cp, uint32_t hopsPerSecond) {
+  engines.spo2->seedDc(cp.redDc, cp.irDc);
+  engines.hrBank->seedDc(cp.pulseDc);
+  if (engines.spectrumBank) engines.spectrumBank->seedDc(cp.pulseDc);
+  if (engines.morphology) engines.morphology->seedDc(cp.pulseDc);
+  if (cp.flags & CHECKPOINT_FROM_NVS) return;
+
+  uint32_t hopsSlept = cp.sleepSeconds * hopsPerSecond;
+  if (cp.flags & CHECKPOINT_HAS_HR) {
+    engines.fusion->heartRateState().restore(cp.hrState, cp.hrVar);
+    engines.fusion->heartRateState().predict(hopsSlept);
+    if (engines.tracker && engines.spectrumBank)
+      engines.tracker->setPrior(*engines.spectrumBank, cp.hrState / (float)KALMAN_ONE);
+  }
+  if (cp.flags & CHECKPOINT_HAS_SPO2) {
+    engines.fusion->spo2State().restore(cp.spo2State, cp.spo2Var);
+    engines.fusion->spo2State().predict(hopsSlept);
+  }
+}
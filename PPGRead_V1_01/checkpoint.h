@@ -0,0 +1,63 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <Arduino.h>
+
+class RegressionSpO2;
+class GoertzelBank;
+class PulseMorphology;
+class HrTracker;
+class VitalsFusion;
+
+// Estimator checkpoint across deep sleep.
+// A compact snapshot of the LED setting, filter baselines and the fused
+// vitals is kept in RTC memory, which survives deep sleep, so a timer
+// wake starts from warm baselines and a known HR instead of an empty state.
+// Other boots ignore it, and a load consumes it. Every
+// CHECKPOINT_NVS_INTERVAL saves it is also written to NVS, so a cold boot
+// can still recover the slow-changing parts (LED setting and baselines).
+
+#define CHECKPOINT_MAGIC 0x5047  // "PG"
+#define CHECKPOINT_VERSION 3
+#define CHECKPOINT_NVS_INTERVAL 60
+
+#define CHECKPOINT_HAS_HR 0x01
+#define CHECKPOINT_HAS_SPO2 0x02
+#define CHECKPOINT_FROM_NVS 0x80  // set on load when only the NVS copy was usable
+
+struct __attribute__((packed)) EstimatorCheckpoint {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t flags;
+  uint8_t ledBrightness;   // LED drive setting
+  uint32_t sleepSeconds;   // planned sleep, ages the vitals on restore
+  uint32_t trackMs;        // track clock at the wake, so it runs on across sleeps
+  float redDc, irDc;       // SpO2 baselines
+  float pulseDc;           // HR channel baseline
+  int32_t hrState, hrVar;      // fused HR, Q16.16
+  int32_t spo2State, spo2Var;  // fused SpO2, Q16.16
+  uint16_t crc;
+};
+
+uint16_t crc16(const uint8_t *data, size_t len);
+void checkpointSave(EstimatorCheckpoint *cp);  // fills magic, version and crc
+bool checkpointLoad(EstimatorCheckpoint *cp);  // RTC copy on a timer wake, else NVS copy
+void checkpointClear();
+
+// The estimators a checkpoint snapshots and seeds. The spectrum bank,
+// tracker and morphology are optional (null: skipped).
+struct CheckpointEngines {
+  RegressionSpO2 *spo2;
+  GoertzelBank *hrBank;
+  GoertzelBank *spectrumBank;
+  HrTracker *tracker;
+  PulseMorphology *morphology;
+  VitalsFusion *fusion;
+};
+
+// Baselines and fused vitals into cp; the caller sets the LED, sleep and clock fields
+void checkpointCapture(const CheckpointEngines &engines, EstimatorCheckpoint *cp);
+// Warm-start from cp, ageing the vitals by the hops slept
+void checkpointRestore(const CheckpointEngines &engines, const EstimatorCheckpoint &cp, uint32_t hopsPerSecond);
+
+#endif
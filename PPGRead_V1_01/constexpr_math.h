@@ -0,0 +1,52 @@
+#ifndef CONSTEXPR_MATH_H
+#define CONSTEXPR_MATH_H
+
+// Compile-time math for table builders and static_assert checks.
+// libm isn't constexpr, so these are plain series and Newton iterations in
+// double, accurate to ~1e-12 over the ranges the designers use. They are
+// slow at run time; call them only where the compiler folds the result.
+
+#if __cplusplus < 201402L
+#error "constexpr_math.h needs C++14 constexpr (arduino-esp32 3.x)"
+#endif
+
+namespace cx {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kLn2 = 0.69314718055994530942;
+
+constexpr double abs(double x) { return x < 0 ? -x : x; }
+
+constexpr double sin(double x) {
+  while (x > kPi) x -= 2 * kPi;
+  while (x < -kPi) x += 2 * kPi;
+  double term = x, sum = x;
+  for (int i = 1; i < 14; i++) {
+    term *= -x * x / ((2 * i) * (2 * i + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double cos(double x) { return sin(x + kPi / 2); }
+
+constexpr double sqrt(double x) {
+  if (x <= 0) return 0;
+  double r = x > 1 ? x : 1;
+  for (int i = 0; i < 64; i++) r = 0.5 * (r + x / r);
+  return r;
+}
+
+// ln via atanh: ln x = 2 atanh((x - 1) / (x + 1)), fast for x in [1, 2]
+constexpr double log2(double x) {
+  double t = (x - 1) / (x + 1), t2 = t * t, term = t, sum = 0;
+  for (int i = 0; i < 20; i++) {
+    sum += term / (2 * i + 1);
+    term *= t2;
+  }
+  return 2 * sum / kLn2;
+}
+
+}  // namespace cx
+
+#endif
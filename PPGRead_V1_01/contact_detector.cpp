@@ -0,0 +1,85 @@
+#include "contact_detector.h"
+
+// MAX3010x register values, not exported by the SparkFun header
+#define CONTACT_MODE_REDIRONLY 0x03
+#define CONTACT_MODE_MULTILED 0x07
+#define CONTACT_INT_PROX 0x10  // PROX_INT bit of interrupt status 1
+
+void ContactDetector::begin(MAX30105 *s, byte ledMode, byte drive, byte greenDrive, uint32_t level,
+                            uint16_t samples) {
+  sensor = s;
+  modeRegister = ledMode >= 3 ? CONTACT_MODE_MULTILED : CONTACT_MODE_REDIRONLY;
+  amplitude = drive;
+  greenAmplitude = greenDrive;
+  lossLevel = level;
+  // Reflected light scales with the LED current, so the skin shows up at
+  // the pilot current roughly this far down
+  searchLevel = drive ? (uint32_t)((uint64_t)level * CONTACT_PILOT_CURRENT / drive) : level;
+  lossSamples = samples;
+  search();
+}
+
+#if CONTACT_HW_PROXIMITY
+void ContactDetector::search() {
+  sensor->setPulseAmplitudeProximity(CONTACT_PILOT_CURRENT);
+  sensor->setProximityThreshold(CONTACT_PROX_THRESHOLD);
+  sensor->enablePROXINT();
+  sensor->getINT1();                  // drop a stale PROX_INT
+  sensor->setLEDMode(modeRegister);   // writing the mode restarts in proximity mode
+  state = CONTACT_SEARCH;
+  lowCount = 0;
+}
+
+bool ContactDetector::poll() {
+  if (state == CONTACT_ON) return true;
+  if (!(sensor->getINT1() & CONTACT_INT_PROX)) return false;
+  restore();  // the part is in normal mode now
+  return true;
+}
+#else
+void ContactDetector::search() {
+  sensor->setPulseAmplitudeRed(0);
+  sensor->setPulseAmplitudeGreen(0);
+  sensor->setPulseAmplitudeIR(CONTACT_PILOT_CURRENT);
+  sensor->clearFIFO();
+  state = CONTACT_SEARCH;
+  lowCount = 0;
+  hits = 0;
+}
+
+// Drains whatever the pilot produced since the last call
+bool ContactDetector::poll() {
+  if (state == CONTACT_ON) return true;
+  sensor->check();
+  while (sensor->available()) {
+    uint32_t ir = sensor->getFIFOIR();
+    sensor->nextSample();
+    hits = ir >= searchLevel ? hits + 1 : 0;
+    if (hits >= CONTACT_SEARCH_HITS) {
+      sensor->setPulseAmplitudeRed(amplitude);
+      sensor->setPulseAmplitudeIR(amplitude);
+      sensor->setPulseAmplitudeGreen(greenAmplitude);
+      restore();
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+// Pilot samples are no use to the pipeline; start from an empty FIFO
+void ContactDetector::restore() {
+  sensor->clearFIFO();
+  state = CONTACT_ON;
+  lowCount = 0;
+}
+
+bool ContactDetector::addSample(uint32_t ir) {
+  if (state != CONTACT_ON) return false;
+  lowCount = ir < lossLevel ? lowCount + 1 : 0;
+  if (lowCount >= lossSamples) {
+    search();
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,56 @@
+#ifndef CONTACT_DETECTOR_H
+#define CONTACT_DETECTOR_H
+
+#include <Arduino.h>
+#include "MAX30105.h"
+
+// Skin-contact state machine gating full-power acquisition.
+// Off the skin only a low-current pilot IR LED runs, red and the third
+// slot are dark, and the pipeline stops computing. While searching, the IR
+// reading is compared with the loss threshold scaled down to the pilot
+// current; a short run of readings above it restores the LEDs. On the skin,
+// a sustained drop of the IR level below the loss threshold goes back to
+// searching.
+//
+// The MAX30102 has no proximity function, so the search runs in software on
+// every part. MAX30105-class parts can leave it to the hardware instead
+// (CONTACT_HW_PROXIMITY): the part idles in proximity mode and raises
+// PROX_INT when it switches itself to normal mode.
+
+#ifndef CONTACT_HW_PROXIMITY
+#define CONTACT_HW_PROXIMITY 0  // 1 only on parts with PROX_INT (MAX30101/MAX30105)
+#endif
+
+#define CONTACT_PILOT_CURRENT 0x04   // ~0.8 mA pilot LED while searching
+#define CONTACT_PROX_THRESHOLD 0x08  // 8 MSBs of the ADC count (~8k counts), hardware search
+#define CONTACT_SEARCH_HITS 5        // consecutive pilot readings above threshold, software search
+
+enum ContactState : uint8_t { CONTACT_SEARCH, CONTACT_ON };
+
+class ContactDetector {
+public:
+  // ledMode as passed to MAX30105::setup() (2 = red + IR, 3 = three slots);
+  // amplitude is the red/IR drive restored on contact, greenAmplitude the
+  // third slot's (0 when it samples ambient light)
+  void begin(MAX30105 *sensor, byte ledMode, byte amplitude, byte greenAmplitude, uint32_t lossLevel,
+             uint16_t lossSamples);
+  bool onSkin() const { return state == CONTACT_ON; }
+  bool poll();                  // while searching: true once contact is detected
+  bool addSample(uint32_t ir);  // while on skin: false once contact is lost
+
+private:
+  void search();
+  void restore();
+
+  MAX30105 *sensor;
+  uint8_t modeRegister;
+  byte amplitude, greenAmplitude;
+  uint32_t lossLevel;
+  uint32_t searchLevel;  // lossLevel at the pilot current
+  uint16_t lossSamples;
+  uint16_t lowCount;
+  uint8_t hits;
+  ContactState state;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "debug_log.h"
+
+static Print *logOut;
+static uint32_t events, bytes;
+
+#if !LOG_DEFERRED
+// Only messages at or above LOG_LEVEL keep their text; the rest can never
+// be written, so their slot holds an empty string and the format stays out
+// of flash
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_KEEP_DEBUG(format) format
+#else
+#define LOG_KEEP_DEBUG(format) ""
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_KEEP_INFO(format) format
+#else
+#define LOG_KEEP_INFO(format) ""
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_KEEP_WARN(format) format
+#else
+#define LOG_KEEP_WARN(format) ""
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_KEEP_ERROR(format) format
+#else
+#define LOG_KEEP_ERROR(format) ""
+#endif
+
+#define LOG_FORMAT_ENTRY(id, level, format) LOG_KEEP_##level(format),
+static const char *const formats[] = { LOG_MESSAGES(LOG_FORMAT_ENTRY) };
+#undef LOG_FORMAT_ENTRY
+#endif
+
+void logBegin(Print &out) {
+  logOut = &out;
+  events = bytes = 0;
+}
+
+uint32_t logEvents() {
+  return events;
+}
+
+uint32_t logBytes() {
+  return bytes;
+}
+
+static size_t printValue(Print &out, const LogValue &v) {
+  switch (v.kind) {
+    case LogValue::INT: return out.print(v.i);
+    case LogValue::UINT: return out.print(v.u);
+    case LogValue::FLOAT: return out.print(v.f, v.digits);
+    case LogValue::STR: return out.print(v.s);
+    default: return out.print(LOG_DEFERRED ? "-" : "--");
+  }
+}
+
+#if !LOG_DEFERRED
+// Just enough of printf for the table: flags and width are skipped,
+// precision applies to %f, and the value's own kind decides the rest
+// (%v keeps the decimals the value was logged with)
+static size_t printFormatted(Print &out, const char *format, const LogValue *args, size_t count) {
+  size_t n = 0, next = 0;
+  for (const char *p = format; *p; p++) {
+    if (*p != '%') {
+      n += out.write(*p);
+      continue;
+    }
+    p++;
+    if (*p == '%') {
+      n += out.write('%');
+      continue;
+    }
+    uint8_t digits = 2;
+    while (*p && strchr("-+ 0#123456789", *p)) p++;
+    if (*p == '.') {
+      digits = 0;
+      while (*++p >= '0' && *p <= '9') digits = digits * 10 + (*p - '0');
+    }
+    if (!*p) break;
+    if (next >= count) continue;
+    LogValue v = args[next++];
+    if (v.kind == LogValue::FLOAT && *p == 'f') v.digits = digits;
+    if (*p == 'x' && v.kind != LogValue::NONE) {
+      n += out.print(v.u, HEX);
+    } else {
+      n += printValue(out, v);
+    }
+  }
+  return n;
+}
+#endif
+
+void logWrite(LogId id, std::initializer_list<LogValue> args) {
+  if (!logOut) return;
+  size_t n;
+#if LOG_DEFERRED
+  n = logOut->print("L,");
+  n += logOut->print((unsigned)id);
+  for (const LogValue &v : args) {
+    n += logOut->write(',');
+    n += printValue(*logOut, v);
+  }
+#else
+  n = printFormatted(*logOut, formats[id], args.begin(), args.size());
+#endif
+  n += logOut->println();
+  events++;
+  bytes += n;
+}
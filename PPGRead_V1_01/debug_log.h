@@ -0,0 +1,80 @@
+#ifndef DEBUG_LOG_H
+#define DEBUG_LOG_H
+
+#include <Arduino.h>
+#include <initializer_list>
+#include "log_messages.h"
+
+// Leveled logging with compile-time removal and deferred formatting.
+// Messages are declared once in log_messages.h. A DLOG() below LOG_LEVEL is
+// a constant-false branch, so the call and its arguments compile away. With
+// LOG_DEFERRED the device sends only L,<id>,<arg>,... and the format strings
+// never reach flash; tools/log_decode.py formats the lines on the host and
+// passes everything else through. LOG_DEFERRED 0 formats on the device for a
+// plain serial monitor.
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG  // LOG_LEVEL_INFO or above for production
+#endif
+#ifndef LOG_DEFERRED
+#define LOG_DEFERRED 1
+#endif
+
+#define LOG_ID_ENTRY(id, level, format) LOG_##id,
+enum LogId : uint16_t { LOG_MESSAGES(LOG_ID_ENTRY) LOG_MESSAGE_COUNT };
+#undef LOG_ID_ENTRY
+
+#define LOG_LEVEL_ENTRY(id, level, format) LOG_LEVEL_##level,
+constexpr uint8_t logLevels[] = { LOG_MESSAGES(LOG_LEVEL_ENTRY) };
+#undef LOG_LEVEL_ENTRY
+
+// One argument; integers, floats (sent with `digits` decimals), strings
+// without commas, or nothing for an invalid reading
+struct LogValue {
+  enum Kind : uint8_t { INT, UINT, FLOAT, STR, NONE };
+  Kind kind;
+  uint8_t digits;
+  union {
+    int32_t i;
+    uint32_t u;
+    float f;
+    const char *s;
+  };
+
+  LogValue(int v) : kind(INT), digits(0), i(v) {}
+  LogValue(long v) : kind(INT), digits(0), i(v) {}
+  LogValue(unsigned v) : kind(UINT), digits(0), u(v) {}
+  LogValue(unsigned long v) : kind(UINT), digits(0), u(v) {}
+  LogValue(float v, uint8_t d = 2) : kind(FLOAT), digits(d), f(v) {}
+  LogValue(double v, uint8_t d = 2) : kind(FLOAT), digits(d), f(v) {}
+  LogValue(const char *v) : kind(STR), digits(0), s(v) {}
+  static LogValue none() {
+    LogValue v(0);
+    v.kind = NONE;
+    return v;
+  }
+};
+
+// Reading for a %v conversion: the value if valid, -- otherwise
+inline LogValue logValid(int32_t value, bool valid) { return valid ? LogValue(value) : LogValue::none(); }
+inline LogValue logValid(float value, bool valid, uint8_t digits) {
+  return valid ? LogValue(value, digits) : LogValue::none();
+}
+
+void logBegin(Print &out);
+void logWrite(LogId id, std::initializer_list<LogValue> args);
+uint32_t logEvents();
+uint32_t logBytes();  // on the wire, line endings included
+
+#define DLOG(id, ...) \
+  do { \
+    if (logLevels[LOG_##id] >= LOG_LEVEL) logWrite(LOG_##id, { __VA_ARGS__ }); \
+  } while (0)
+
+#endif
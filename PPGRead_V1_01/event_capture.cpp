@@ -0,0 +1,158 @@
+#include "event_capture.h"
+
+#define CAPTURE_SPO2_BASELINE_ALPHA 0.02f  // per valid hop
+#define CAPTURE_MAX_SAMPLE_BYTES 6         // two 3-byte varints (18-bit deltas)
+
+void EventCapture::begin(const CaptureConfig &c) {
+  config = c;
+  spo2Baseline = 0;
+  invalidHops = 0;
+  lowSignal = false;
+  sampleCount = 0;
+  reset();
+}
+
+void EventCapture::reset() {
+  writePos = 0;
+  firstSeq = nextSeq = 0;
+  state = CAPTURE_ARMED;
+  truncated = false;
+}
+
+void EventCapture::putVarint(uint32_t v) {
+  while (v >= 0x80) {
+    putByte((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  putByte((uint8_t)v);
+}
+
+uint32_t EventCapture::getVarint(uint32_t *pos) const {
+  uint32_t v = 0;
+  for (uint8_t shift = 0; shift < 32; shift += 7) {
+    uint8_t b = ring[(*pos)++ % CAPTURE_RING_BYTES];
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) break;
+  }
+  return v;
+}
+
+static inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+// Evict old blocks until bytes more fit. Fails if that would eat into a capture.
+bool EventCapture::makeRoom(uint16_t bytes) {
+  while (firstSeq != nextSeq) {
+    bool full = writePos + bytes - block(firstSeq).start > CAPTURE_RING_BYTES || nextSeq - firstSeq >= CAPTURE_MAX_BLOCKS;
+    if (!full) break;
+    if (state == CAPTURE_POST && firstSeq >= protectSeq) return false;
+    firstSeq++;
+  }
+  return true;
+}
+
+void EventCapture::addSample(uint32_t red, uint32_t ir) {
+  sampleCount++;
+  if (state == CAPTURE_EXPORT) return;  // frozen until exported
+
+  bool open = nextSeq != firstSeq && block(nextSeq - 1).samples < CAPTURE_BLOCK_SAMPLES;
+  if (!open) {
+    if (!makeRoom(8 + CAPTURE_MAX_SAMPLE_BYTES)) {
+      truncated = true;
+      state = CAPTURE_EXPORT;
+      return;
+    }
+    Block &b = block(nextSeq++);
+    b.start = writePos;
+    b.firstSample = sampleCount - 1;
+    b.samples = 1;
+    for (uint8_t i = 0; i < 4; i++) putByte((uint8_t)(red >> (8 * i)));
+    for (uint8_t i = 0; i < 4; i++) putByte((uint8_t)(ir >> (8 * i)));
+  } else {
+    if (!makeRoom(CAPTURE_MAX_SAMPLE_BYTES)) {
+      truncated = true;
+      state = CAPTURE_EXPORT;
+      return;
+    }
+    putVarint(zigzag((int32_t)(red - lastRed)));
+    putVarint(zigzag((int32_t)(ir - lastIr)));
+    block(nextSeq - 1).samples++;
+  }
+  lastRed = red;
+  lastIr = ir;
+
+  if (state == CAPTURE_POST && --postLeft == 0) state = CAPTURE_EXPORT;
+}
+
+void EventCapture::trigger(uint8_t why) {
+  if (state != CAPTURE_ARMED || firstSeq == nextSeq) return;
+  reason = why;
+  truncated = false;
+  // Protect the blocks that hold the pre-trigger time
+  uint32_t preSamples = (uint32_t)config.preSeconds * CAPTURE_BLOCK_SAMPLES;
+  protectSeq = nextSeq - 1;
+  while (protectSeq > firstSeq && sampleCount - block(protectSeq).firstSample < preSamples) protectSeq--;
+  postLeft = (uint32_t)config.postSeconds * CAPTURE_BLOCK_SAMPLES;
+  state = postLeft ? CAPTURE_POST : CAPTURE_EXPORT;
+
+  exportSeq = protectSeq;
+  exportSample = 0;
+}
+
+void EventCapture::checkVitals(int32_t spo2, int8_t validSpo2, int8_t validHeartRate, uint32_t ir) {
+  uint8_t fired = 0;
+
+  if (validSpo2) {
+    if (spo2Baseline == 0) spo2Baseline = spo2;
+    if (spo2 + config.spo2Drop <= spo2Baseline) fired |= CAPTURE_TRIGGER_SPO2_DROP;
+    spo2Baseline += CAPTURE_SPO2_BASELINE_ALPHA * (spo2 - spo2Baseline);
+  }
+
+  invalidHops = validHeartRate ? 0 : invalidHops < 0xFF ? invalidHops + 1 : invalidHops;
+  if (invalidHops == config.invalidHrHops) fired |= CAPTURE_TRIGGER_HR_INVALID;  // once per run
+
+  bool low = ir < config.lowSignalIr;
+  if (low && !lowSignal) fired |= CAPTURE_TRIGGER_LOW_SIGNAL;  // on the falling edge only
+  lowSignal = low;
+
+  fired &= config.triggers;
+  if (fired) trigger(fired);
+}
+
+bool EventCapture::exportTo(Print &out, uint16_t maxLines) {
+  if (state != CAPTURE_EXPORT) return false;
+
+  for (uint16_t line = 0; line < maxLines; line++) {
+    if (exportSeq == nextSeq) {
+      out.println(truncated ? "CAPTURE END (truncated)" : "CAPTURE END");
+      reset();
+      return false;
+    }
+    Block &b = block(exportSeq);
+    if (exportSeq == protectSeq && exportSample == 0) {
+      out.print("CAPTURE reason: 0x");
+      out.print(reason, HEX);
+      out.print(", first sample: ");
+      out.println(b.firstSample);
+    }
+    if (exportSample == 0) {
+      exportPos = b.start;
+      exportRed = exportIr = 0;
+      for (uint8_t i = 0; i < 4; i++) exportRed |= (uint32_t)ring[exportPos++ % CAPTURE_RING_BYTES] << (8 * i);
+      for (uint8_t i = 0; i < 4; i++) exportIr |= (uint32_t)ring[exportPos++ % CAPTURE_RING_BYTES] << (8 * i);
+    } else {
+      exportRed += unzigzag(getVarint(&exportPos));
+      exportIr += unzigzag(getVarint(&exportPos));
+    }
+    out.print("C,");
+    out.print(exportIr);
+    out.print(",");
+    out.println(exportRed);
+
+    if (++exportSample == b.samples) {
+      exportSeq++;
+      exportSample = 0;
+    }
+  }
+  return true;
+}
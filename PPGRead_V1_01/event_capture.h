@@ -0,0 +1,82 @@
+#ifndef EVENT_CAPTURE_H
+#define EVENT_CAPTURE_H
+
+#include <Arduino.h>
+
+// Event-triggered raw capture with a compressed pre-trigger ring.
+// Raw red/IR samples are delta + zigzag varint coded into 1 s blocks (each
+// block starts with absolute values so it decodes on its own); the oldest
+// blocks are evicted as the ring fills. On a trigger the blocks covering the
+// pre-trigger time are protected, recording continues for the post-trigger
+// time, and the frozen capture is then exported a few lines per loop so the
+// acquisition path never waits on the serial link.
+
+#define CAPTURE_RING_BYTES 8192
+#define CAPTURE_MAX_BLOCKS 32
+#define CAPTURE_BLOCK_SAMPLES 100   // 1 s at 100 Hz
+
+// Trigger sources, combine as a mask
+#define CAPTURE_TRIGGER_SPO2_DROP  0x01
+#define CAPTURE_TRIGGER_HR_INVALID 0x02
+#define CAPTURE_TRIGGER_LOW_SIGNAL 0x04
+#define CAPTURE_TRIGGER_MANUAL     0x80
+
+struct CaptureConfig {
+  uint8_t triggers;        // enabled trigger mask
+  uint8_t preSeconds;
+  uint8_t postSeconds;
+  uint8_t spo2Drop;        // points below the running SpO2 baseline
+  uint8_t invalidHrHops;   // consecutive invalid HR hops
+  uint32_t lowSignalIr;    // IR level under which the contact is lost
+};
+
+class EventCapture {
+public:
+  void begin(const CaptureConfig &config);
+  void addSample(uint32_t red, uint32_t ir);  // call for every sample
+  // Evaluate the configured triggers once per hop
+  void checkVitals(int32_t spo2, int8_t validSpo2, int8_t validHeartRate, uint32_t ir);
+  void trigger(uint8_t reason);  // ignored while a capture is in progress
+  // Emit up to maxLines of a finished capture; returns true while output is pending
+  bool exportTo(Print &out, uint16_t maxLines);
+  bool busy() const { return state != CAPTURE_ARMED; }
+
+private:
+  enum State : uint8_t { CAPTURE_ARMED, CAPTURE_POST, CAPTURE_EXPORT };
+  struct Block {
+    uint32_t start;        // absolute byte position in the ring
+    uint32_t firstSample;  // sample index of the first sample
+    uint8_t samples;
+  };
+
+  Block &block(uint32_t seq) { return blocks[seq % CAPTURE_MAX_BLOCKS]; }
+  void putByte(uint8_t b) { ring[writePos++ % CAPTURE_RING_BYTES] = b; }
+  void putVarint(uint32_t v);
+  uint32_t getVarint(uint32_t *pos) const;
+  bool makeRoom(uint16_t bytes);
+  void reset();
+
+  CaptureConfig config;
+  uint8_t ring[CAPTURE_RING_BYTES];
+  Block blocks[CAPTURE_MAX_BLOCKS];
+  uint32_t writePos;
+  uint32_t firstSeq, nextSeq;  // live blocks are [firstSeq, nextSeq)
+  uint32_t sampleCount;
+  uint32_t lastRed, lastIr;
+
+  State state;
+  uint8_t reason;
+  bool truncated;
+  uint32_t protectSeq;    // oldest block that belongs to the capture
+  uint32_t postLeft;      // samples still to record after the trigger
+  float spo2Baseline;
+  uint8_t invalidHops;
+  bool lowSignal;
+
+  // Export cursor
+  uint32_t exportSeq, exportPos;
+  uint8_t exportSample;
+  uint32_t exportRed, exportIr;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include "fast_math.h"
+#include <math.h>
+
+#define FAST_MATH_BENCH_N 256      // inputs per sweep
+#define FAST_MATH_BENCH_LO 1e-6f   // sweep covers the estimators' range:
+#define FAST_MATH_BENCH_HI 1e12f   // normalized powers up to raw DC squared
+
+extern constexpr FastMathTables fastMathTables{};
+
+namespace {
+
+// Seed error is largest at the interval ends, as both functions are monotonic
+constexpr double recipSeedError() {
+  double worst = 0;
+  for (int i = 0; i < FAST_MATH_SIZE; i++) {
+    double a = 1 + (double)i / FAST_MATH_SIZE, b = a + 1.0 / FAST_MATH_SIZE;
+    double ea = cx::abs(fastMathTables.recip[i] * a - 1), eb = cx::abs(fastMathTables.recip[i] * b - 1);
+    if (ea > worst) worst = ea;
+    if (eb > worst) worst = eb;
+  }
+  return worst;
+}
+
+constexpr double rsqrtSeedError() {
+  double worst = 0;
+  for (int i = 0; i < 2 * FAST_MATH_SIZE; i++) {
+    double a = (1 + (double)(i % FAST_MATH_SIZE) / FAST_MATH_SIZE) * (i < FAST_MATH_SIZE ? 1 : 2);
+    double b = a + (i < FAST_MATH_SIZE ? 1.0 : 2.0) / FAST_MATH_SIZE;
+    double ea = cx::abs(fastMathTables.rsqrt[i] * cx::sqrt(a) - 1), eb = cx::abs(fastMathTables.rsqrt[i] * cx::sqrt(b) - 1);
+    if (ea > worst) worst = ea;
+    if (eb > worst) worst = eb;
+  }
+  return worst;
+}
+
+// Chord error of the stored table, worst at mid-interval for a concave
+// curve; sampled at FAST_MATH_LOG2_STEPS points per interval
+#define FAST_MATH_LOG2_STEPS 16
+constexpr double log2InterpolationError() {
+  double worst = 0;
+  for (int i = 0; i < FAST_MATH_SIZE; i++) {
+    for (int k = 1; k < FAST_MATH_LOG2_STEPS; k++) {
+      double frac = (double)k / FAST_MATH_LOG2_STEPS;
+      double approx = fastMathTables.log2[i] + frac * (fastMathTables.log2[i + 1] - fastMathTables.log2[i]);
+      double e = cx::abs(approx - cx::log2(1 + (i + frac) / FAST_MATH_SIZE));
+      if (e > worst) worst = e;
+    }
+  }
+  return worst;
+}
+
+// Newton: 1 - x r' = e^2 for the reciprocal, 1.5 e^2 + 0.5 e^3 for rsqrt
+constexpr double recipSeed = recipSeedError();
+constexpr double rsqrtSeed = rsqrtSeedError();
+static_assert(recipSeed < 7.8e-3, "reciprocal seed");
+static_assert(recipSeed * recipSeed < 6.1e-5, "reciprocal bound");
+static_assert(rsqrtSeed < 3.9e-3, "rsqrt seed");
+static_assert(1.5 * rsqrtSeed * rsqrtSeed + 0.5 * rsqrtSeed * rsqrtSeed * rsqrtSeed < 2.3e-5, "rsqrt bound");
+static_assert(cx::abs(fastMathTables.log2[FAST_MATH_SIZE] - 1) < 1e-7, "log2 table end");
+static_assert(cx::abs(fastMathTables.log2[FAST_MATH_SIZE / 2] - 0.5849625) < 1e-7, "log2(1.5)");
+constexpr double log2Interpolation = log2InterpolationError();
+static_assert(log2Interpolation < 4.4e-5, "log2 bound");
+static_assert(log2Interpolation * cx::kLn2 < 3.1e-5, "log bound");
+
+volatile float benchSink;
+
+float benchInput(uint16_t i) {
+  return FAST_MATH_BENCH_LO * powf(FAST_MATH_BENCH_HI / FAST_MATH_BENCH_LO, (float)i / (FAST_MATH_BENCH_N - 1));
+}
+
+// Cycles per call over the sweep, loop overhead included on both sides
+template <typename F>
+float benchCycles(const float *x, F f) {
+  float acc = 0;
+  uint32_t start = ESP.getCycleCount();
+  for (uint16_t i = 0; i < FAST_MATH_BENCH_N; i++) acc += f(x[i]);
+  uint32_t cycles = ESP.getCycleCount() - start;
+  benchSink = acc;
+  return (float)cycles / FAST_MATH_BENCH_N;
+}
+
+template <typename F, typename G>
+void benchPair(FastMathBench *out, const char *name, const float *x, F fast, G libm, bool relative) {
+  out->name = name;
+  out->fastCycles = benchCycles(x, fast);
+  out->libmCycles = benchCycles(x, libm);
+  out->maxError = 0;
+  for (uint16_t i = 0; i < FAST_MATH_BENCH_N; i++) {
+    float want = libm(x[i]);
+    float err = fabsf(fast(x[i]) - want);
+    if (relative) err /= fabsf(want);
+    if (err > out->maxError) out->maxError = err;
+  }
+}
+
+}  // namespace
+
+void fastMathBenchmark(FastMathBench out[FAST_MATH_BENCH_COUNT]) {
+  static float x[FAST_MATH_BENCH_N];
+  for (uint16_t i = 0; i < FAST_MATH_BENCH_N; i++) x[i] = benchInput(i);
+
+  benchPair(&out[0], "recip", x, [](float v) { return fastRecip(v); }, [](float v) { return 1.0f / v; }, true);
+  benchPair(&out[1], "rsqrt", x, [](float v) { return fastRsqrt(v); }, [](float v) { return 1.0f / sqrtf(v); }, true);
+  benchPair(&out[2], "sqrt", x, [](float v) { return fastSqrt(v); }, [](float v) { return sqrtf(v); }, true);
+  benchPair(&out[3], "log2", x, [](float v) { return fastLog2(v); }, [](float v) { return log2f(v); }, false);
+  benchPair(&out[4], "log", x, [](float v) { return fastLog(v); }, [](float v) { return logf(v); }, false);
+}
@@ -0,0 +1,110 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <Arduino.h>
+#include <string.h>
+#include "constexpr_math.h"
+
+// Division-free reciprocal, square root and log for the estimators.
+// The S3 FPU multiplies and adds in a cycle but has no divide or square
+// root instruction, so libm runs an iterative sequence for each. Here the
+// top FAST_MATH_BITS of the mantissa index a table built by the compiler,
+// and one Newton step (or linear interpolation for log) refines the seed.
+// Inputs must be positive normal floats; callers already guard x > 0.
+//
+// Error bounds (checked against the tables in fast_math.cpp):
+//   fastRecip   relative 6.1e-5   (seed 7.8e-3, Newton squares it)
+//   fastRsqrt   relative 2.3e-5   (seed 3.9e-3, Newton gives 1.5 e^2)
+//   fastSqrt    relative 2.3e-5   (x * fastRsqrt(x))
+//   fastLog2    absolute 4.4e-5   (interpolation h^2 / 8 ln 2)
+//   fastLog     absolute 3.1e-5
+// plus float rounding of the result, which for the logs grows with the
+// exponent: over the benchmark sweep (log2 up to ~40) fastLog2 reaches
+// ~4.7e-5. A second Newton step would take reciprocal and rsqrt to
+// rounding level; the estimators don't need it.
+
+#define FAST_MATH_BITS 6
+#define FAST_MATH_SIZE (1 << FAST_MATH_BITS)
+
+// Seeds are the minimax constant over each mantissa interval [a, b):
+// 2 / (a + b) for 1/x, 2 / (sqrt(a) + sqrt(b)) for 1/sqrt(x). Rsqrt covers
+// two octaves so an odd exponent can be folded into the mantissa.
+struct FastMathTables {
+  float recip[FAST_MATH_SIZE];
+  float rsqrt[2 * FAST_MATH_SIZE];
+  float log2[FAST_MATH_SIZE + 1];
+
+  constexpr FastMathTables() : recip(), rsqrt(), log2() {
+    for (int i = 0; i < FAST_MATH_SIZE; i++) {
+      double a = 1 + (double)i / FAST_MATH_SIZE, b = a + 1.0 / FAST_MATH_SIZE;
+      recip[i] = (float)(2 / (a + b));
+      rsqrt[i] = (float)(2 / (cx::sqrt(a) + cx::sqrt(b)));
+      rsqrt[FAST_MATH_SIZE + i] = (float)(2 / (cx::sqrt(2 * a) + cx::sqrt(2 * b)));
+    }
+    for (int i = 0; i <= FAST_MATH_SIZE; i++) log2[i] = (float)cx::log2(1 + (double)i / FAST_MATH_SIZE);
+  }
+};
+
+extern const FastMathTables fastMathTables;
+
+inline uint32_t fastMathBits(float x) {
+  uint32_t u;
+  memcpy(&u, &x, sizeof(u));
+  return u;
+}
+
+inline float fastMathFloat(uint32_t u) {
+  float x;
+  memcpy(&x, &u, sizeof(x));
+  return x;
+}
+
+// x = m 2^e with m in [1, 2): 1/x = (1/m) 2^-e, the power built directly
+inline float fastRecip(float x) {
+  uint32_t u = fastMathBits(x);
+  uint32_t e = (u >> 23) & 0xff;
+  float r = fastMathTables.recip[(u >> (23 - FAST_MATH_BITS)) & (FAST_MATH_SIZE - 1)] *
+            fastMathFloat((254 - e) << 23);
+  return r * (2.0f - x * r);
+}
+
+// Odd exponents use the [2, 4) half of the table, leaving an even power
+// whose square root is exact
+inline float fastRsqrt(float x) {
+  uint32_t u = fastMathBits(x);
+  int32_t e = (int32_t)((u >> 23) & 0xff) - 127;
+  uint32_t index = (u >> (23 - FAST_MATH_BITS)) & (FAST_MATH_SIZE - 1);
+  if (e & 1) {
+    index += FAST_MATH_SIZE;
+    e -= 1;
+  }
+  float y = fastMathTables.rsqrt[index] * fastMathFloat((uint32_t)(127 - e / 2) << 23);
+  return y * (1.5f - 0.5f * x * y * y);
+}
+
+inline float fastSqrt(float x) { return x > 0 ? x * fastRsqrt(x) : 0; }
+
+inline float fastLog2(float x) {
+  uint32_t u = fastMathBits(x);
+  int32_t e = (int32_t)((u >> 23) & 0xff) - 127;
+  uint32_t index = (u >> (23 - FAST_MATH_BITS)) & (FAST_MATH_SIZE - 1);
+  float frac = (float)(u & ((1 << (23 - FAST_MATH_BITS)) - 1)) * (1.0f / (1 << (23 - FAST_MATH_BITS)));
+  const float *t = fastMathTables.log2 + index;
+  return e + t[0] + frac * (t[1] - t[0]);
+}
+
+inline float fastLog(float x) { return fastLog2(x) * 0.69314718f; }
+
+// On-device comparison against libm over a log-spaced sweep of inputs
+struct FastMathBench {
+  const char *name;
+  float fastCycles;  // per call
+  float libmCycles;
+  float maxError;    // relative, absolute for the logs
+};
+
+#define FAST_MATH_BENCH_COUNT 5
+
+void fastMathBenchmark(FastMathBench out[FAST_MATH_BENCH_COUNT]);
+
+#endif
@@ -0,0 +1,51 @@
+#include "filter_design.h"
+
+// Compile-time checks of the designers; this file emits no code.
+
+namespace {
+
+constexpr double fs = 100;
+
+// 2nd-order low-pass: unity at DC, -3 dB at the cutoff, deep stop band
+constexpr auto lp2 = butterworthLowpass<2>(fs, 8);
+static_assert(cx::abs(gainAt(lp2, fs, 0) - 1) < 1e-4, "low-pass DC gain");
+static_assert(cx::abs(gainAt(lp2, fs, 8) - 0.70711) < 1e-3, "low-pass -3 dB point");
+static_assert(gainAt(lp2, fs, 40) < 0.05, "low-pass stop band");
+static_assert(cx::abs(lp2.section[0].b0 * 2 - lp2.section[0].b1) < 1e-7, "low-pass numerator shape");
+static_assert(stable(lp2) && fitsQ30(lp2) && stable(quantizeQ30(lp2)), "low-pass fixed point");
+
+// 4th-order: maximally flat, so still -3 dB at the cutoff and steeper past it
+constexpr auto lp4 = butterworthLowpass<4>(fs, 8);
+static_assert(cx::abs(gainAt(lp4, fs, 8) - 0.70711) < 1e-3, "4th-order -3 dB point");
+static_assert(gainAt(lp4, fs, 16) < gainAt(lp2, fs, 16) * 0.5, "4th-order roll-off");
+static_assert(cx::abs(gainAt(lp4, fs, 2) - 1) < 1e-3, "4th-order flat pass band");
+
+// HR band-pass, 0.5-4 Hz (30-240 bpm)
+constexpr auto bp = butterworthBandpass<2>(fs, 0.5, 4);
+static_assert(gainAt(bp, fs, 0) < 1e-4, "band-pass rejects DC");
+static_assert(gainAt(bp, fs, 1.5) > 0.9, "band-pass passes HR");
+static_assert(gainAt(bp, fs, 25) < 0.05, "band-pass rejects HF");
+static_assert(stable(bp) && stable(quantizeQ30(bp)), "band-pass stability");
+
+// A very low cutoff pushes the poles toward z = 1; quantization must hold them inside
+constexpr auto hpLow = butterworthHighpass<2>(fs, 0.05);
+static_assert(stable(hpLow) && stable(quantizeQ30(hpLow)), "low-cutoff high-pass fixed point");
+
+// FIR: linear phase, unity DC, stop band
+constexpr auto fir = firLowpass<31>(fs, 10);
+static_assert(symmetric(fir), "FIR symmetry");
+static_assert(cx::abs(gainAt(fir, fs, 0) - 1) < 1e-5, "FIR DC gain");
+static_assert(gainAt(fir, fs, 25) < 0.01, "FIR stop band");
+static_assert(fitsQ15(fir), "FIR Q15 range");
+
+// 63 taps resolve ~5 Hz transitions at 100 Hz, so the HR band is left to the IIR
+constexpr auto firBp = firBandpass<63>(fs, 10, 30);
+static_assert(gainAt(firBp, fs, 0) < 0.01 && gainAt(firBp, fs, 45) < 0.01, "FIR band-pass stop bands");
+static_assert(cx::abs(gainAt(firBp, fs, 20) - 1) < 0.01, "FIR band-pass pass band");
+
+// Math helpers against known values
+static_assert(cx::abs(cx::sin(cx::kPi / 6) - 0.5) < 1e-12, "sin");
+static_assert(cx::abs(cx::cos(4 * cx::kPi / 3) + 0.5) < 1e-12, "cos after range reduction");
+static_assert(cx::abs(cx::sqrt(2) - 1.41421356237) < 1e-10, "sqrt");
+
+}  // namespace
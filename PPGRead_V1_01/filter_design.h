@@ -0,0 +1,303 @@
+#ifndef FILTER_DESIGN_H
+#define FILTER_DESIGN_H
+
+#include <Arduino.h>
+#include "constexpr_math.h"
+
+// Compile-time filter design.
+// Butterworth biquad cascades (bilinear transform, RBJ sections) and
+// Hamming-windowed sinc FIRs are designed by constexpr functions from the
+// sample rate and cutoffs, so a filter is declared as
+//   constexpr auto lp = butterworthLowpass<2>(100, 8);
+// and its coefficients, fixed-point forms and stability checks are all
+// settled by the compiler. Gains can be evaluated at compile time too, which
+// is how filter_design.cpp checks the designers with static_assert. Design
+// math is done in double; the kernels below run in float or Q30 integers.
+
+// Normalized biquad, a0 = 1: y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2
+struct Biquad {
+  float b0, b1, b2, a1, a2;
+};
+
+template <int N>
+struct BiquadCascade {
+  Biquad section[N];
+};
+
+// Same cascade in Q30 (coefficients must lie in (-2, 2))
+template <int N>
+struct BiquadCascadeQ30 {
+  int32_t b[N][3];
+  int32_t a[N][2];
+};
+
+template <int TAPS>
+struct Fir {
+  float h[TAPS];
+};
+
+template <int TAPS>
+struct FirQ15 {
+  int16_t h[TAPS];
+};
+
+// --- Biquad design ---
+
+enum BiquadType : uint8_t { BIQUAD_LOWPASS, BIQUAD_HIGHPASS };
+
+constexpr Biquad rbjSection(BiquadType type, double fs, double fc, double q) {
+  double w0 = 2 * cx::kPi * fc / fs;
+  double alpha = cx::sin(w0) / (2 * q);
+  double c = cx::cos(w0);
+  double a0 = 1 + alpha;
+  double b0 = type == BIQUAD_LOWPASS ? (1 - c) / 2 : (1 + c) / 2;
+  double b1 = type == BIQUAD_LOWPASS ? 1 - c : -(1 + c);
+  return Biquad{ (float)(b0 / a0), (float)(b1 / a0), (float)(b0 / a0), (float)(-2 * c / a0), (float)((1 - alpha) / a0) };
+}
+
+// Even-order Butterworth as ORDER/2 sections with Q_k = 1 / (2 sin((2k+1) pi / 2N))
+template <int ORDER>
+constexpr BiquadCascade<ORDER / 2> butterworth(BiquadType type, double fs, double fc) {
+  static_assert(ORDER >= 2 && ORDER % 2 == 0, "Butterworth order must be even");
+  BiquadCascade<ORDER / 2> c{};
+  for (int k = 0; k < ORDER / 2; k++) {
+    double q = 1 / (2 * cx::sin((2 * k + 1) * cx::kPi / (2 * ORDER)));
+    c.section[k] = rbjSection(type, fs, fc, q);
+  }
+  return c;
+}
+
+template <int ORDER>
+constexpr BiquadCascade<ORDER / 2> butterworthLowpass(double fs, double fc) {
+  return butterworth<ORDER>(BIQUAD_LOWPASS, fs, fc);
+}
+
+template <int ORDER>
+constexpr BiquadCascade<ORDER / 2> butterworthHighpass(double fs, double fc) {
+  return butterworth<ORDER>(BIQUAD_HIGHPASS, fs, fc);
+}
+
+// Band-pass as an ORDER high-pass at low followed by an ORDER low-pass at high
+template <int ORDER>
+constexpr BiquadCascade<ORDER> butterworthBandpass(double fs, double low, double high) {
+  BiquadCascade<ORDER> c{};
+  BiquadCascade<ORDER / 2> hp = butterworthHighpass<ORDER>(fs, low);
+  BiquadCascade<ORDER / 2> lp = butterworthLowpass<ORDER>(fs, high);
+  for (int k = 0; k < ORDER / 2; k++) {
+    c.section[k] = hp.section[k];
+    c.section[ORDER / 2 + k] = lp.section[k];
+  }
+  return c;
+}
+
+// Poles inside the unit circle (stability triangle)
+constexpr bool stable(double a1, double a2) {
+  return a2 < 1 && a2 > -1 && cx::abs(a1) < 1 + a2;
+}
+
+template <int N>
+constexpr bool stable(const BiquadCascade<N> &c) {
+  for (int k = 0; k < N; k++) {
+    if (!stable(c.section[k].a1, c.section[k].a2)) return false;
+  }
+  return true;
+}
+
+// |H(f)| of the cascade
+template <int N>
+constexpr double gainAt(const BiquadCascade<N> &c, double fs, double f) {
+  double w = 2 * cx::kPi * f / fs;
+  double c1 = cx::cos(w), s1 = cx::sin(w), c2 = cx::cos(2 * w), s2 = cx::sin(2 * w);
+  double g2 = 1;
+  for (int k = 0; k < N; k++) {
+    const Biquad &q = c.section[k];
+    double nr = q.b0 + q.b1 * c1 + q.b2 * c2, ni = -(q.b1 * s1 + q.b2 * s2);
+    double dr = 1 + q.a1 * c1 + q.a2 * c2, di = -(q.a1 * s1 + q.a2 * s2);
+    g2 *= (nr * nr + ni * ni) / (dr * dr + di * di);
+  }
+  return cx::sqrt(g2);
+}
+
+// --- Fixed point ---
+
+constexpr int32_t toQ30(double x) {
+  return (int32_t)(x * 1073741824.0 + (x >= 0 ? 0.5 : -0.5));
+}
+
+constexpr bool fitsQ30(double x) { return x > -2 && x < 2; }
+
+template <int N>
+constexpr bool fitsQ30(const BiquadCascade<N> &c) {
+  for (int k = 0; k < N; k++) {
+    const Biquad &q = c.section[k];
+    if (!fitsQ30(q.b0) || !fitsQ30(q.b1) || !fitsQ30(q.b2) || !fitsQ30(q.a1) || !fitsQ30(q.a2)) return false;
+  }
+  return true;
+}
+
+template <int N>
+constexpr BiquadCascadeQ30<N> quantizeQ30(const BiquadCascade<N> &c) {
+  BiquadCascadeQ30<N> q{};
+  for (int k = 0; k < N; k++) {
+    q.b[k][0] = toQ30(c.section[k].b0);
+    q.b[k][1] = toQ30(c.section[k].b1);
+    q.b[k][2] = toQ30(c.section[k].b2);
+    q.a[k][0] = toQ30(c.section[k].a1);
+    q.a[k][1] = toQ30(c.section[k].a2);
+  }
+  return q;
+}
+
+// Stability of the coefficients as quantized, not as designed
+template <int N>
+constexpr bool stable(const BiquadCascadeQ30<N> &q) {
+  for (int k = 0; k < N; k++) {
+    if (!stable(q.a[k][0] / 1073741824.0, q.a[k][1] / 1073741824.0)) return false;
+  }
+  return true;
+}
+
+// --- FIR design ---
+
+// Hamming-windowed sinc low-pass, unity gain at DC
+template <int TAPS>
+constexpr Fir<TAPS> firLowpass(double fs, double fc) {
+  static_assert(TAPS >= 3 && TAPS % 2 == 1, "odd tap count keeps the delay an integer");
+  Fir<TAPS> f{};
+  double wc = 2 * cx::kPi * fc / fs;
+  double sum = 0;
+  for (int n = 0; n < TAPS; n++) {
+    double m = n - (TAPS - 1) / 2.0;
+    double sinc = m == 0 ? wc / cx::kPi : cx::sin(wc * m) / (cx::kPi * m);
+    double h = sinc * (0.54 - 0.46 * cx::cos(2 * cx::kPi * n / (TAPS - 1)));
+    f.h[n] = (float)h;
+    sum += h;
+  }
+  for (int n = 0; n < TAPS; n++) f.h[n] = (float)(f.h[n] / sum);
+  return f;
+}
+
+// Band-pass as the difference of two low-passes
+template <int TAPS>
+constexpr Fir<TAPS> firBandpass(double fs, double low, double high) {
+  Fir<TAPS> f{};
+  Fir<TAPS> hi = firLowpass<TAPS>(fs, high);
+  Fir<TAPS> lo = firLowpass<TAPS>(fs, low);
+  for (int n = 0; n < TAPS; n++) f.h[n] = hi.h[n] - lo.h[n];
+  return f;
+}
+
+template <int TAPS>
+constexpr double gainAt(const Fir<TAPS> &f, double fs, double freq) {
+  double w = 2 * cx::kPi * freq / fs;
+  double re = 0, im = 0;
+  for (int n = 0; n < TAPS; n++) {
+    re += f.h[n] * cx::cos(w * n);
+    im -= f.h[n] * cx::sin(w * n);
+  }
+  return cx::sqrt(re * re + im * im);
+}
+
+template <int TAPS>
+constexpr bool symmetric(const Fir<TAPS> &f) {
+  for (int n = 0; n < TAPS / 2; n++) {
+    if (f.h[n] != f.h[TAPS - 1 - n]) return false;
+  }
+  return true;
+}
+
+template <int TAPS>
+constexpr bool fitsQ15(const Fir<TAPS> &f) {
+  for (int n = 0; n < TAPS; n++) {
+    if (f.h[n] >= 1 || f.h[n] < -1) return false;
+  }
+  return true;
+}
+
+template <int TAPS>
+constexpr FirQ15<TAPS> quantizeQ15(const Fir<TAPS> &f) {
+  FirQ15<TAPS> q{};
+  for (int n = 0; n < TAPS; n++) q.h[n] = (int16_t)(f.h[n] * 32768.0 + (f.h[n] >= 0 ? 0.5 : -0.5));
+  return q;
+}
+
+// --- Kernels ---
+
+// Transposed direct form II, one state pair per section
+template <int N>
+class BiquadFilter {
+public:
+  constexpr explicit BiquadFilter(const BiquadCascade<N> &design) : c(design), s{} {}
+  void reset() {
+    for (int k = 0; k < N; k++) s[k][0] = s[k][1] = 0;
+  }
+  float process(float x) {
+    for (int k = 0; k < N; k++) {
+      const Biquad &q = c.section[k];
+      float y = q.b0 * x + s[k][0];
+      s[k][0] = q.b1 * x - q.a1 * y + s[k][1];
+      s[k][1] = q.b2 * x - q.a2 * y;
+      x = y;
+    }
+    return x;
+  }
+
+private:
+  BiquadCascade<N> c;
+  float s[N][2];
+};
+
+// Direct form I in Q30 with 64-bit accumulation; the input keeps its scale
+template <int N>
+class BiquadFilterQ30 {
+public:
+  constexpr explicit BiquadFilterQ30(const BiquadCascadeQ30<N> &design) : q(design), x1{}, x2{}, y1{}, y2{} {}
+  void reset() {
+    for (int k = 0; k < N; k++) x1[k] = x2[k] = y1[k] = y2[k] = 0;
+  }
+  int32_t process(int32_t x) {
+    for (int k = 0; k < N; k++) {
+      int64_t acc = (int64_t)q.b[k][0] * x + (int64_t)q.b[k][1] * x1[k] + (int64_t)q.b[k][2] * x2[k]
+                    - (int64_t)q.a[k][0] * y1[k] - (int64_t)q.a[k][1] * y2[k];
+      int32_t y = (int32_t)((acc + (1 << 29)) >> 30);
+      x2[k] = x1[k];
+      x1[k] = x;
+      y2[k] = y1[k];
+      y1[k] = y;
+      x = y;
+    }
+    return x;
+  }
+
+private:
+  BiquadCascadeQ30<N> q;
+  int32_t x1[N], x2[N], y1[N], y2[N];
+};
+
+template <int TAPS>
+class FirFilter {
+public:
+  constexpr explicit FirFilter(const Fir<TAPS> &design) : f(design), buf{}, pos(0) {}
+  void reset() {
+    for (int n = 0; n < TAPS; n++) buf[n] = 0;
+    pos = 0;
+  }
+  float process(float x) {
+    buf[pos] = x;
+    float acc = 0;
+    uint16_t j = pos;
+    for (int n = 0; n < TAPS; n++) {
+      acc += f.h[n] * buf[j];
+      j = j ? j - 1 : TAPS - 1;
+    }
+    pos = pos + 1 < TAPS ? pos + 1 : 0;
+    return acc;
+  }
+
+private:
+  Fir<TAPS> f;
+  float buf[TAPS];
+  uint16_t pos;
+};
+
+#endif
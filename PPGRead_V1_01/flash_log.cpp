@@ -0,0 +1,137 @@
+#include "flash_log.h"
+#include "checkpoint.h"  // crc16
+#include <stddef.h>
+
+#define FLASH_LOG_MAGIC 0x474C5056  // "VPLG"
+#define RECORD_HEADER_BYTES 8
+#define RECORD_CRC_BYTES 2
+
+struct __attribute__((packed)) SectorHeader {
+  uint32_t magic;
+  uint32_t sectorSeq;
+  uint32_t firstSeq;  // sequence of the first record in the sector
+  uint16_t reserved;
+  uint16_t crc;
+};
+
+struct __attribute__((packed)) RecordHeader {
+  uint32_t seq;
+  uint16_t length;
+  uint8_t type;
+  uint8_t reserved;
+};
+
+static uint32_t recordBytes(uint16_t length) {
+  return (RECORD_HEADER_BYTES + length + RECORD_CRC_BYTES + 3) & ~3u;
+}
+
+static bool readHeader(const esp_partition_t *partition, uint32_t sector, SectorHeader *h) {
+  if (esp_partition_read(partition, sector * FLASH_LOG_SECTOR_BYTES, h, sizeof(*h)) != ESP_OK) return false;
+  return h->magic == FLASH_LOG_MAGIC && h->crc == crc16((const uint8_t *)h, offsetof(SectorHeader, crc));
+}
+
+bool FlashLog::begin(const char *partitionLabel) {
+  uint32_t t0 = micros();
+  partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partitionLabel);
+  if (!partition) return false;
+  sectors = partition->size / FLASH_LOG_SECTOR_BYTES;
+  recovered = 0;
+  torn = false;
+
+  // Newest valid checkpoint; a sector torn during erase or header write fails its CRC
+  bool found = false;
+  SectorHeader newest;
+  for (uint32_t i = 0; i < sectors; i++) {
+    SectorHeader h;
+    if (!readHeader(partition, i, &h)) continue;
+    if (!found || (int32_t)(h.sectorSeq - newest.sectorSeq) > 0) {
+      newest = h;
+      sector = i;
+      found = true;
+    }
+  }
+
+  bool ok;
+  if (found) {
+    sectorSeq = newest.sectorSeq;
+    scanSector(sector, newest.firstSeq);
+    ok = true;
+  } else {
+    sectorSeq = 0;
+    seq = 0;
+    ok = openSector(0);
+  }
+  recoveryTime = micros() - t0;
+  return ok;
+}
+
+// Walk the records of a sector to the first slot that is erased or damaged
+void FlashLog::scanSector(uint32_t s, uint32_t firstSeq) {
+  uint32_t end = (s + 1) * FLASH_LOG_SECTOR_BYTES;
+  offset = s * FLASH_LOG_SECTOR_BYTES + sizeof(SectorHeader);
+  seq = firstSeq;
+
+  uint8_t buf[RECORD_HEADER_BYTES + FLASH_LOG_MAX_PAYLOAD + RECORD_CRC_BYTES];
+  RecordHeader *h = (RecordHeader *)buf;
+  while (offset + RECORD_HEADER_BYTES <= end) {
+    if (esp_partition_read(partition, offset, buf, RECORD_HEADER_BYTES) != ESP_OK) break;
+    bool erased = true;
+    for (uint8_t i = 0; i < RECORD_HEADER_BYTES; i++) erased &= buf[i] == 0xFF;
+    if (erased) return;  // clean end of the log
+
+    uint32_t bytes = recordBytes(h->length);
+    uint16_t crc;
+    if (h->seq != seq || h->length > FLASH_LOG_MAX_PAYLOAD || offset + bytes > end
+        || esp_partition_read(partition, offset + RECORD_HEADER_BYTES, buf + RECORD_HEADER_BYTES, h->length) != ESP_OK
+        || esp_partition_read(partition, offset + RECORD_HEADER_BYTES + h->length, &crc, sizeof(crc)) != ESP_OK
+        || crc != crc16(buf, RECORD_HEADER_BYTES + h->length)) {
+      break;
+    }
+    offset += bytes;
+    seq++;
+    recovered++;
+  }
+
+  // Torn record: never program over it, the next append starts a new sector
+  torn = offset + RECORD_HEADER_BYTES <= end;
+  offset = end;
+}
+
+bool FlashLog::openSector(uint32_t s) {
+  sector = s;
+  offset = s * FLASH_LOG_SECTOR_BYTES;
+  if (esp_partition_erase_range(partition, offset, FLASH_LOG_SECTOR_BYTES) != ESP_OK) return false;
+
+  SectorHeader h;
+  h.magic = FLASH_LOG_MAGIC;
+  h.sectorSeq = ++sectorSeq;
+  h.firstSeq = seq;
+  h.reserved = 0xFFFF;
+  h.crc = crc16((const uint8_t *)&h, offsetof(SectorHeader, crc));
+  if (esp_partition_write(partition, offset, &h, sizeof(h)) != ESP_OK) return false;
+  offset += sizeof(h);
+  return true;
+}
+
+bool FlashLog::append(uint8_t type, const void *payload, uint16_t length) {
+  if (!partition || length > FLASH_LOG_MAX_PAYLOAD) return false;
+  uint32_t bytes = recordBytes(length);
+  if (offset + bytes > (sector + 1) * FLASH_LOG_SECTOR_BYTES && !openSector((sector + 1) % sectors)) return false;
+
+  // One write per record, CRC last, padding left erased
+  uint8_t buf[(RECORD_HEADER_BYTES + FLASH_LOG_MAX_PAYLOAD + RECORD_CRC_BYTES + 3) & ~3u];
+  memset(buf, 0xFF, bytes);
+  RecordHeader *h = (RecordHeader *)buf;
+  h->seq = seq;
+  h->length = length;
+  h->type = type;
+  h->reserved = 0xFF;
+  memcpy(buf + RECORD_HEADER_BYTES, payload, length);
+  uint16_t crc = crc16(buf, RECORD_HEADER_BYTES + length);
+  memcpy(buf + RECORD_HEADER_BYTES + length, &crc, sizeof(crc));
+  if (esp_partition_write(partition, offset, buf, bytes) != ESP_OK) return false;
+
+  offset += bytes;
+  seq++;
+  return true;
+}
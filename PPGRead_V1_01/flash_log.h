@@ -0,0 +1,59 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+
+// Power-fail tolerant record log in a raw flash partition.
+// The partition is a ring of 4 KB sectors. Each sector starts with a CRC'd
+// header that doubles as a checkpoint (sector sequence and the first record
+// sequence in it); records carry their own sequence number and a CRC written
+// last. A write cut short by power loss fails its CRC and ends the log there;
+// the next append moves on to a fresh sector instead of programming over the
+// damaged bytes. Boot recovery reads every sector header (16 bytes each)
+// and then scans only the newest sector: O(sectors) header reads plus one
+// sector of records, so the record scan does not grow with the log.
+
+#define FLASH_LOG_SECTOR_BYTES 4096
+#define FLASH_LOG_MAX_PAYLOAD 64
+
+// Record types
+#define FLASH_RECORD_BOOT 1         // FlashBootRecord, once per boot
+#define FLASH_RECORD_TRACK_POINT 2  // FlashTrackRecord, archived vitals point
+
+struct __attribute__((packed)) FlashBootRecord {
+  uint32_t sleptSeconds;  // deep sleep before this boot, 0 on a cold start
+};
+
+struct __attribute__((packed)) FlashTrackRecord {
+  uint32_t ms;     // track clock: since the cold boot, across timer wakes
+  float value;
+  char track;      // 'H' or 'S'
+  uint8_t valid;   // 0 marks the start of a gap
+};
+
+class FlashLog {
+public:
+  bool begin(const char *partitionLabel);  // find the partition and recover
+  bool append(uint8_t type, const void *payload, uint16_t length);
+  uint32_t nextSeq() const { return seq; }
+  uint32_t recoveryMicros() const { return recoveryTime; }
+  uint16_t recoveredRecords() const { return recovered; }  // scanned in the newest sector
+  bool recoveredTorn() const { return torn; }             // the last write was cut short
+
+private:
+  bool openSector(uint32_t sector);
+  void scanSector(uint32_t sector, uint32_t firstSeq);
+
+  const esp_partition_t *partition;
+  uint32_t sectors;
+  uint32_t sector;       // sector being written
+  uint32_t sectorSeq;    // its header sequence
+  uint32_t offset;       // next write position in the partition
+  uint32_t seq;          // next record sequence
+  uint32_t recoveryTime;
+  uint16_t recovered;
+  bool torn;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include "goertzel_hr.h"
+
+#define GOERTZEL_DC_ALPHA 0.02f     // ~0.5 s DC tracker at 100 Hz
+#define GOERTZEL_PEAK_RATIO 2.0f    // peak must exceed mean bin power by this
+
+void GoertzelBank::begin(float fs, float centerBpm, float step, uint8_t n, float tauSec) {
+  sampleRate = fs;
+  stepBpm = step;
+  numBins = n > GOERTZEL_MAX_BINS ? GOERTZEL_MAX_BINS : n;
+  r = expf(-1.0f / (tauSec * fs));
+  firstIndex = 0;
+  reset();
+  recenter(centerBpm);
+}
+
+void GoertzelBank::reset() {
+  dcInit = false;
+  memset(s1, 0, sizeof(s1));
+  memset(s2, 0, sizeof(s2));
+  subS1 = subS2 = 0;
+}
+
+void GoertzelBank::updateCoefs() {
+  for (uint8_t i = 0; i < numBins; i++) {
+    float w = 2.0f * PI * (binBpm(i) / 60.0f) / sampleRate;
+    coef[i] = 2.0f * r * cosf(w);
+  }
+  float w = 2.0f * PI * (binBpm(numBins / 2) / 120.0f) / sampleRate;
+  subCoef = 2.0f * r * cosf(w);
+  subS1 = subS2 = 0;
+}
+
+void GoertzelBank::recenter(float bpm) {
+  int16_t lo = (int16_t)(GOERTZEL_MIN_BPM / stepBpm);
+  int16_t hi = (int16_t)(GOERTZEL_MAX_BPM / stepBpm) - numBins + 1;
+  int16_t start = (int16_t)(bpm / stepBpm + 0.5f) - numBins / 2;
+  if (start > hi) start = hi;
+  if (start < lo) start = lo;
+
+  int16_t shift = start - firstIndex;
+  if (shift == 0) return;
+  if (shift > 0 && shift < numBins) {
+    memmove(s1, s1 + shift, (numBins - shift) * sizeof(float));
+    memmove(s2, s2 + shift, (numBins - shift) * sizeof(float));
+    memset(s1 + numBins - shift, 0, shift * sizeof(float));
+    memset(s2 + numBins - shift, 0, shift * sizeof(float));
+  } else if (shift < 0 && -shift < numBins) {
+    memmove(s1 - shift, s1, (numBins + shift) * sizeof(float));
+    memmove(s2 - shift, s2, (numBins + shift) * sizeof(float));
+    memset(s1, 0, -shift * sizeof(float));
+    memset(s2, 0, -shift * sizeof(float));
+  } else {
+    memset(s1, 0, sizeof(s1));
+    memset(s2, 0, sizeof(s2));
+  }
+  firstIndex = start;
+  updateCoefs();
+}
+
+void GoertzelBank::addSample(uint32_t ir) {
+  if (!dcInit) {
+    dc = ir;
+    dcInit = true;
+  }
+  dc += GOERTZEL_DC_ALPHA * ((float)ir - dc);
+  addSample((float)ir - dc);
+}
+
+void GoertzelBank::addSample(float x) {
+  float r2 = r * r;
+  for (uint8_t i = 0; i < numBins; i++) {
+    float s0 = x + coef[i] * s1[i] - r2 * s2[i];
+    s2[i] = s1[i];
+    s1[i] = s0;
+  }
+  float s0 = x + subCoef * subS1 - r2 * subS2;
+  subS2 = subS1;
+  subS1 = s0;
+}
+
+float GoertzelBank::binPower(uint8_t i) const {
+  // |s1 - r e^-jw s2|^2
+  return s1[i] * s1[i] + r * r * s2[i] * s2[i] - coef[i] * s1[i] * s2[i];
+}
+
+bool GoertzelBank::estimate(int32_t *heartRate, int8_t *validHeartRate) {
+  uint8_t peak = 0;
+  float peakPower = 0, total = 0;
+  for (uint8_t i = 0; i < numBins; i++) {
+    float p = binPower(i);
+    total += p;
+    if (p > peakPower) {
+      peakPower = p;
+      peak = i;
+    }
+  }
+
+  bool valid = numBins >= 3 && peakPower > GOERTZEL_PEAK_RATIO * total / numBins;
+  float bpm = binBpm(peak);
+  if (peak == 0 || peak == numBins - 1) {
+    // Peak on the band edge: the true HR is likely outside, move towards it
+    valid = false;
+  } else {
+    float pl = binPower(peak - 1), pr = binPower(peak + 1);
+    float den = pl - 2.0f * peakPower + pr;
+    if (den < 0) bpm += 0.5f * (pl - pr) / den * stepBpm;
+  }
+
+  // Strong energy at half the center: we are sitting on the harmonic
+  float subPower = subS1 * subS1 + r * r * subS2 * subS2 - subCoef * subS1 * subS2;
+  if (binBpm(numBins / 2) / 2.0f >= GOERTZEL_MIN_BPM && subPower > peakPower) {
+    valid = false;
+    bpm = binBpm(numBins / 2) / 2.0f;
+  }
+
+  if (valid) *heartRate = (int32_t)(bpm + 0.5f);
+  *validHeartRate = valid;
+  recenter(bpm);
+  return valid;
+}
@@ -0,0 +1,57 @@
+#ifndef GOERTZEL_HR_H
+#define GOERTZEL_HR_H
+
+#include <Arduino.h>
+
+// Streaming Goertzel filter bank for low-cost HR tracking.
+// Each bin is a damped Goertzel resonator updated once per sample, so the
+// cost is O(bins) per sample instead of a full FFT per window. Only a band of
+// bins around the last HR is evaluated; the band follows the estimate, and a
+// single probe at half the band center catches locks onto the 2nd harmonic.
+
+#define GOERTZEL_MAX_BINS 64
+#define GOERTZEL_MIN_BPM 40
+#define GOERTZEL_MAX_BPM 200
+
+class GoertzelBank {
+public:
+  // tauSec sets the resonator memory (effective window length)
+  void begin(float sampleRate, float centerBpm, float stepBpm, uint8_t numBins, float tauSec = 4.0f);
+  void addSample(uint32_t ir);
+  void addSample(float x);            // already DC-free input
+  void recenter(float bpm);           // move the band, keeping overlapping bin states
+  void reset();
+
+  // Peak pick with parabolic refinement. Returns true on a valid estimate.
+  bool estimate(int32_t *heartRate, int8_t *validHeartRate);
+
+  // Checkpoint support: input baseline
+  float dcLevel() const { return dc; }
+  void seedDc(float level) {
+    dc = level;
+    dcInit = true;
+  }
+
+  uint8_t bins() const { return numBins; }
+  float binBpm(uint8_t i) const { return (firstIndex + i) * stepBpm; }
+  float binPower(uint8_t i) const;
+
+private:
+  void updateCoefs();
+
+  float sampleRate;
+  float stepBpm;
+  float r;           // resonator pole radius
+  float dc;          // DC tracker for raw IR input
+  bool dcInit;
+  int16_t firstIndex;  // grid index of bin 0 (bpm = index * stepBpm)
+  uint8_t numBins;
+  float coef[GOERTZEL_MAX_BINS];  // 2 r cos(w)
+  float s1[GOERTZEL_MAX_BINS];
+  float s2[GOERTZEL_MAX_BINS];
+
+  // Probe at half the band center, to catch locks onto the 2nd harmonic
+  float subCoef, subS1, subS2;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "hr_tracker.h"
+#include "fast_math.h"
+
+#define HR_TRACK_FLOOR 1e-6f          // keeps log() finite on empty bins
+#define HR_TRACK_MIN_CONFIDENCE 1.0f  // mean path log-power above a flat spectrum
+
+void HrTracker::begin(uint8_t n, float penalty) {
+  numBins = n > HR_TRACK_MAX_BINS ? HR_TRACK_MAX_BINS : n;
+  jumpPenalty = penalty;
+  reset();
+}
+
+void HrTracker::reset() {
+  memset(score, 0, sizeof(score));
+  head = HR_TRACK_HISTORY - 1;
+  count = 0;
+}
+
+void HrTracker::setPrior(const GoertzelBank &bank, float bpm) {
+  float first = bank.binBpm(0);
+  float step = bank.binBpm(1) - first;
+  float prior = (bpm - first) / step;
+  for (uint8_t j = 0; j < numBins; j++) score[j] = -jumpPenalty * fabsf(j - prior);
+}
+
+void HrTracker::addColumn(const GoertzelBank &bank) {
+  firstBpm = bank.binBpm(0);
+  stepBpm = bank.binBpm(1) - firstBpm;
+
+  // Normalized log spectrum, so columns are comparable across signal levels
+  float total = 0;
+  for (uint8_t i = 0; i < numBins; i++) total += bank.binPower(i);
+  if (total <= 0) total = 1;
+
+  head = (head + 1) % HR_TRACK_HISTORY;
+  float *column = logPower[head];
+  uint8_t *ptr = back[head];
+  float scale = fastRecip(total);
+  for (uint8_t i = 0; i < numBins; i++) column[i] = fastLog(bank.binPower(i) * scale + HR_TRACK_FLOOR);
+
+  // Forward step, transitions limited to +-HR_TRACK_MAX_JUMP bins
+  float next[HR_TRACK_MAX_BINS];
+  float best = -1e30f;
+  for (uint8_t j = 0; j < numBins; j++) {
+    int lo = j - HR_TRACK_MAX_JUMP < 0 ? 0 : j - HR_TRACK_MAX_JUMP;
+    int hi = j + HR_TRACK_MAX_JUMP >= numBins ? numBins - 1 : j + HR_TRACK_MAX_JUMP;
+    float s = -1e30f;
+    uint8_t from = j;
+    for (int i = lo; i <= hi; i++) {
+      float c = score[i] - jumpPenalty * abs(i - (int)j);
+      if (c > s) {
+        s = c;
+        from = i;
+      }
+    }
+    next[j] = s + column[j];
+    ptr[j] = from;
+    if (next[j] > best) best = next[j];
+  }
+  // Renormalize so scores stay bounded over long runs
+  for (uint8_t j = 0; j < numBins; j++) score[j] = next[j] - best;
+
+  if (count < HR_TRACK_HISTORY) count++;
+}
+
+bool HrTracker::estimate(int32_t *heartRate, int8_t *validHeartRate) {
+  *validHeartRate = 0;
+  if (count <= HR_TRACK_LAG) return false;
+
+  uint8_t state = 0;
+  for (uint8_t j = 1; j < numBins; j++)
+    if (score[j] > score[state]) state = j;
+
+  // Backtrack HR_TRACK_LAG hops, scoring the path against the spectrogram
+  uint8_t slot = head;
+  float pathLog = 0;
+  for (uint8_t k = 0; k < HR_TRACK_LAG; k++) {
+    pathLog += logPower[slot][state];
+    state = back[slot][state];
+    slot = (slot + HR_TRACK_HISTORY - 1) % HR_TRACK_HISTORY;
+  }
+  pathLog += logPower[slot][state];
+
+  float flatLog = -fastLog(numBins);
+  bool valid = pathLog / (HR_TRACK_LAG + 1) - flatLog > HR_TRACK_MIN_CONFIDENCE;
+  if (valid) *heartRate = (int32_t)(firstBpm + state * stepBpm + 0.5f);
+  *validHeartRate = valid;
+  return valid;
+}
@@ -0,0 +1,45 @@
+#ifndef HR_TRACKER_H
+#define HR_TRACKER_H
+
+#include <Arduino.h>
+#include "goertzel_hr.h"
+
+// Spectral HR tracker across windows.
+// Keeps a rolling spectrogram of the last HR_TRACK_HISTORY hops and runs an
+// incremental Viterbi path search over it: each hop costs
+// O(bins * (2 * HR_TRACK_MAX_JUMP + 1)) for the forward step plus
+// O(HR_TRACK_LAG) for the fixed-lag backtrack. The backtrack is all that
+// reads old columns, so only the lag window is kept.
+
+#define HR_TRACK_MAX_BINS GOERTZEL_MAX_BINS
+#define HR_TRACK_LAG 4        // fixed-lag smoothing delay in hops
+#define HR_TRACK_HISTORY (HR_TRACK_LAG + 1)  // hops kept: the newest + the lag
+#define HR_TRACK_MAX_JUMP 3   // largest physiologic change per hop, in bins
+
+class HrTracker {
+public:
+  // jumpPenalty is the log-likelihood cost per bin of HR change per hop
+  void begin(uint8_t numBins, float jumpPenalty = 0.5f);
+  void reset();
+  // Bias the path towards bpm, e.g. the HR restored from a checkpoint
+  void setPrior(const GoertzelBank &bank, float bpm);
+
+  // Push one spectrogram column (one hop) taken from a full-band bank
+  void addColumn(const GoertzelBank &bank);
+
+  // Smoothed HR, HR_TRACK_LAG hops behind the newest column
+  bool estimate(int32_t *heartRate, int8_t *validHeartRate);
+
+private:
+  uint8_t numBins;
+  float jumpPenalty;
+  float firstBpm, stepBpm;
+
+  float logPower[HR_TRACK_HISTORY][HR_TRACK_MAX_BINS];  // rolling spectrogram
+  uint8_t back[HR_TRACK_HISTORY][HR_TRACK_MAX_BINS];    // Viterbi backpointers
+  float score[HR_TRACK_MAX_BINS];
+  uint8_t head;   // slot of the newest column
+  uint8_t count;  // columns seen, saturating at HR_TRACK_HISTORY
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef LOG_MESSAGES_H
+#define LOG_MESSAGES_H
+
+// Log message table: X(id, level, format). The position in the table is the
+// ID sent on the wire, so only append (or decode with the matching tree).
+// tools/log_decode.py reads this file to format deferred log lines.
+// Conversions: %d %u %x %s %f with optional precision (%.2f), %% and %v for
+// a value that may be invalid (printed as --).
+
+#define LOG_MESSAGES(X) \
+  X(WIRE_BEFORE, DEBUG, "Debug: Before Wire.begin()") \
+  X(WIRE_AFTER, DEBUG, "Debug: After Wire.begin()") \
+  X(SENSOR_PROBE, DEBUG, "Debug: Attempting sensor init") \
+  X(SENSOR_INIT_FAILED, ERROR, "Error: MAX30102 init failed. Check wiring/power/address (0x57).") \
+  X(SENSOR_READY, INFO, "Sensor initialized!") \
+  X(SENSOR_CONFIGURED, INFO, "Sensor configured. Place on skin for PPG data.") \
+  X(TRACKER_MEMORY, DEBUG, "HR tracker memory: %u bytes") \
+  X(FLASH_LOG_RECOVERED, INFO, "Flash log recovered in %u us (%u records scanned%s), next seq %u") \
+  X(FLASH_LOG_MISSING, ERROR, "Error: flash log partition not found") \
+  X(CHECKPOINT_RESTORED, INFO, "Checkpoint restored") \
+  X(CHECKPOINT_RESTORED_NVS, INFO, "Checkpoint restored (NVS)") \
+  X(CHECKPOINT_NONE, INFO, "No checkpoint - cold start") \
+  X(NN_KERNELS_MATCH, DEBUG, "NN kernels match (%s), %u bytes") \
+  X(NN_KERNEL_MISMATCH, ERROR, "Error: NN SIMD kernel mismatch (%s), %u bytes") \
+  X(DISPLAY_INIT_FAILED, ERROR, "Display init failed!") \
+  X(DISPLAY_READY, INFO, "Display ready.") \
+  X(PROFILER_RUNNING, INFO, "Profiler running") \
+  X(PROFILER_FAILED, ERROR, "Error: profiler timer unavailable") \
+  X(SLEEPING, INFO, "Sleeping %u s") \
+  X(CONTACT_ON, INFO, "Skin contact - starting acquisition") \
+  X(CONTACT_LOST, INFO, "Contact lost - searching") \
+  X(BUFFER_FILLED, DEBUG, "Initial buffer filled.") \
+  X(CYCLE_TIME, DEBUG, "Cycle time: %u ms") \
+  X(PIPELINE, DEBUG, "Pipeline: %.2f us/sample, %d channels") \
+  X(RAW_SAMPLE, DEBUG, "Raw PPG - IR: %u, Red: %u") \
+  X(AMBIENT, DEBUG, "Ambient: %u") \
+  X(MAXIM, DEBUG, "HR: %v bpm, SpO2: %v%%") \
+  X(GOERTZEL, DEBUG, "Goertzel HR: %v bpm (%.2f us/sample)") \
+  X(TRACKED, DEBUG, "Tracked HR: %v bpm (%u us/hop)") \
+  X(AUTOCORR, DEBUG, "Autocorr HR: %v bpm (window %u, %u us/hop)") \
+  X(REGRESSION, DEBUG, "Regression SpO2: %v%% (R %.3f, conf %.2f, %u us/hop)") \
+  X(NN, DEBUG, "NN HR: %v bpm (%u us/inference)") \
+  X(BEAT, DEBUG, "Beat - amp: %d, IBI: %u ms, rise: %u ms, width: %u ms, notch: %u ms @ %.2f") \
+  X(MORPH_COST, DEBUG, "Morphology cost: %u us/beat") \
+  X(WINDOWS, DEBUG, "%d s window - HR: %v, SpO2: %v | %d s window - HR: %v, SpO2: %v (%u us/hop)") \
+  X(TEMPLATE, DEBUG, "Template HR: %v bpm (beats %u, NCC %.2f, %.2f us/sample)") \
+  X(FUSED, DEBUG, "Fused HR: %v bpm (var %.1f), Fused SpO2: %v%% (var %.1f, %u us)") \
+  X(TRACK_COMPRESSION, DEBUG, "Track compression: %.1fx (%u us/hop)") \
+  X(TIME_TO_VALID, INFO, "Time to valid reading: %u ms (%s)") \
+  X(LOW_SIGNAL, WARN, "Low signal - Check contact") \
+  X(PROFILER_STATS, DEBUG, "Profiler: %.0f cycles/sample, %u dropped") \
+  X(LOG_STATS, DEBUG, "Log: %u events, %.1f bytes/event") \
+  X(FAST_MATH_BENCH, DEBUG, "Fast %s: %.1f cycles (libm %.1f), max error %.1f ppm") \
+  X(MEMORY_OBJECT, DEBUG, "Memory: %s %u bytes") \
+  X(MEMORY_PLAN, INFO, "Memory plan: %u of %u bytes in pipeline objects, NN %u, heap free %u") \
+  X(HEAP_AFTER_SETUP, ERROR, "Error: %u heap allocations (%u bytes) after setup") \
+  X(BATCH_POOL_BENCH, DEBUG, "Batch pool: %.0f cycles/round solo, %.0f contended, %u exhausted, %u corrupted%s") \
+  X(BATCH_POOL_EMPTY, ERROR, "Error: sample batch pool empty (%u times)") \
+  X(NN_BENCH, DEBUG, "NN inference: %u cycles (%u us), %u bytes")
+
+#endif
@@ -0,0 +1,108 @@
+#include "memory_plan.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+
+static TaskHandle_t sealedTask;
+static volatile uint32_t allocations;
+static volatile uint32_t allocatedBytes;
+static uint32_t freeHeapAtSeal;
+
+// 1 when every allocation call is seen, 0 for the heap-size fallback
+#define MEMORY_PLAN_COUNTS_CALLS (CONFIG_HEAP_USE_HOOKS || MEMORY_PLAN_WRAP)
+
+#if MEMORY_PLAN_COUNTS_CALLS
+// Called on every allocation, possibly before the scheduler runs; only the
+// sealed task's allocations are counted, other tasks own their own heap use
+static void IRAM_ATTR countAllocation(size_t size) {
+  if (sealedTask == NULL || xTaskGetCurrentTaskHandle() != sealedTask) return;
+  allocations = allocations + 1;
+  allocatedBytes = allocatedBytes + size;
+#if MEMORY_PLAN_STRICT
+  abort();
+#endif
+}
+#endif
+
+#if CONFIG_HEAP_USE_HOOKS
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+  (void)caps;
+  if (ptr) countAllocation(size);
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void *ptr) { (void)ptr; }
+#elif MEMORY_PLAN_WRAP
+// The linker sends every malloc/calloc/realloc reference here (String,
+// operator new and the C library alike) and __real_* to the allocator
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *IRAM_ATTR __wrap_malloc(size_t size) {
+  countAllocation(size);
+  return __real_malloc(size);
+}
+
+void *IRAM_ATTR __wrap_calloc(size_t count, size_t size) {
+  countAllocation(count * size);
+  return __real_calloc(count, size);
+}
+
+void *IRAM_ATTR __wrap_realloc(void *ptr, size_t size) {
+  if (size) countAllocation(size);  // realloc(p, 0) frees
+  return __real_realloc(ptr, size);
+}
+}
+#else
+// No hook: compare the default heap with its state at the seal each time
+// the counts are read. This sees every task and only net growth, so an
+// allocation freed before the next read goes unnoticed.
+static multi_heap_info_t heapAtSeal;
+
+static void sampleHeap() {
+  if (sealedTask == NULL) return;
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+  if (info.allocated_blocks <= heapAtSeal.allocated_blocks) return;
+  uint32_t blocks = info.allocated_blocks - heapAtSeal.allocated_blocks;
+  if (blocks <= allocations) return;
+  allocations = blocks;
+  allocatedBytes = info.total_allocated_bytes > heapAtSeal.total_allocated_bytes
+                       ? info.total_allocated_bytes - heapAtSeal.total_allocated_bytes
+                       : 0;
+#if MEMORY_PLAN_STRICT
+  abort();
+#endif
+}
+#endif
+
+void memoryPlanSeal() {
+  freeHeapAtSeal = ESP.getFreeHeap();
+  allocations = 0;
+  allocatedBytes = 0;
+#if !MEMORY_PLAN_COUNTS_CALLS
+  heap_caps_get_info(&heapAtSeal, MALLOC_CAP_DEFAULT);
+#endif
+  sealedTask = xTaskGetCurrentTaskHandle();
+}
+
+void memoryPlanRelease() { sealedTask = NULL; }
+
+bool memoryPlanSealed() { return sealedTask != NULL; }
+
+uint32_t memoryPlanAllocations() {
+#if !MEMORY_PLAN_COUNTS_CALLS
+  sampleHeap();
+#endif
+  return allocations;
+}
+
+uint32_t memoryPlanAllocatedBytes() {
+#if !MEMORY_PLAN_COUNTS_CALLS
+  sampleHeap();
+#endif
+  return allocatedBytes;
+}
+
+uint32_t memoryPlanFreeHeapAtSeal() { return freeHeapAtSeal; }
@@ -0,0 +1,42 @@
+#ifndef MEMORY_PLAN_H
+#define MEMORY_PLAN_H
+
+#include <Arduino.h>
+
+// Static memory plan.
+// Pipeline objects, buffers and queues are globals or module statics, so
+// the layout is fixed at link time: the sketch sums its objects against a
+// budget with static_assert, and tools/memory_report.py lists the whole
+// RAM image from the ELF. After setup() the loop must not touch the heap;
+// memoryPlanSeal() starts counting allocations made by the calling task.
+// How they are seen depends on the build:
+//   CONFIG_HEAP_USE_HOOKS  ESP-IDF heap hooks, every allocation
+//   MEMORY_PLAN_WRAP       linker-wrapped malloc/calloc/realloc, every
+//                          allocation; link with
+//                          -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+//                          (e.g. compiler.c.elf.extra_flags)
+//   neither                net growth of the default heap since the seal,
+//                          sampled when the counts are read; covers all
+//                          tasks and misses anything freed in between
+
+#ifndef MEMORY_PLAN_WRAP
+#define MEMORY_PLAN_WRAP 0  // 1 only when the link wraps the allocators
+#endif
+
+// 1 aborts on the first allocation after the seal, so the panic backtrace
+// points at the caller (with the heap fallback, at the reader instead)
+#ifndef MEMORY_PLAN_STRICT
+#define MEMORY_PLAN_STRICT 0
+#endif
+
+// Plan entries: X(name) for each global, summed or reported by the sketch
+#define MEMORY_PLAN_SIZE(name) +sizeof(name)
+
+void memoryPlanSeal();
+void memoryPlanRelease();  // stop counting, for shutdown paths
+bool memoryPlanSealed();
+uint32_t memoryPlanAllocations();  // since the seal, on the sealed task (all tasks with the fallback)
+uint32_t memoryPlanAllocatedBytes();
+uint32_t memoryPlanFreeHeapAtSeal();
+
+#endif
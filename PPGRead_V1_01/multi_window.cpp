@@ -0,0 +1,136 @@
+#include "multi_window.h"
+#include "fast_math.h"
+
+#define MW_MIN_CONFIDENCE 0.7f  // same gate as RegressionSpO2
+#define MW_MIN_BEATS 2
+#define MW_RHYTHM_BEATS 8       // fewest beats the regularity is judged over
+#define MW_IBI_TOLERANCE 0.2f   // a beat is regular within this of the median interval
+#define MW_SHAPE_TOLERANCE 0.2f // and its rise time and width within this of the medians
+#define MW_SHAPE_SLACK 2        // samples, plus the timing quantization of short rises
+#define MW_AMPLITUDE_TOLERANCE 0.25f  // and its amplitude within this of the median
+#define MW_MIN_REGULAR 0.8f     // fraction of regular beats needed for a window HR
+
+// Median of a few values, by insertion sort on a copy
+template <typename T> static float median(const T *values, uint8_t count) {
+  T sorted[MW_MAX_BEATS];
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t j = i;
+    for (; j > 0 && sorted[j - 1] > values[i]; j--) sorted[j] = sorted[j - 1];
+    sorted[j] = values[i];
+  }
+  return sorted[count / 2];
+}
+
+void MultiWindowEstimator::begin(float fs) {
+  sampleRate = fs;
+  samples = 0;
+  blockCount = 0;
+  memset(&current, 0, sizeof(current));
+  inCurrent = 0;
+  beatCount = 0;
+}
+
+void MultiWindowEstimator::addSample(const RegressionSpO2 &f) {
+  samples++;
+  float red = f.redAcLevel(), ir = f.irAcLevel();
+  current.sII += ir * ir;
+  current.sRI += red * ir;
+  current.sRR += red * red;
+  current.redDc += f.redDcLevel();
+  current.irDc += f.irDcLevel();
+  if (++inCurrent == MW_BLOCK_SAMPLES) {
+    blocks[blockCount++ % MW_MAX_BLOCKS] = current;
+    memset(&current, 0, sizeof(current));
+    inCurrent = 0;
+  }
+}
+
+void MultiWindowEstimator::addBeat(const BeatFeatures &beat) {
+  beatFoot[beatCount % MW_MAX_BEATS] = beat.footIndex;
+  beatIbi[beatCount % MW_MAX_BEATS] = beat.ibiMs;
+  beatRise[beatCount % MW_MAX_BEATS] = beat.riseMs;
+  beatWidth[beatCount % MW_MAX_BEATS] = beat.widthMs;
+  beatAmplitude[beatCount % MW_MAX_BEATS] = beat.amplitude;
+  beatCount++;
+}
+
+bool MultiWindowEstimator::estimate(float seconds, WindowEstimate *out) const {
+  out->validHeartRate = out->validSpo2 = 0;
+  out->confidence = out->regularity = 0;
+
+  // SpO2 over the newest completed blocks covering the window
+  uint32_t want = (uint32_t)(seconds * sampleRate / MW_BLOCK_SAMPLES + 0.5f);
+  if (want > MW_MAX_BLOCKS) want = MW_MAX_BLOCKS;
+  if (want > 0 && blockCount >= want) {
+    Block sum = {0, 0, 0, 0, 0};
+    for (uint32_t k = blockCount - want; k < blockCount; k++) {
+      const Block &b = blocks[k % MW_MAX_BLOCKS];
+      sum.sII += b.sII;
+      sum.sRI += b.sRI;
+      sum.sRR += b.sRR;
+      sum.redDc += b.redDc;
+      sum.irDc += b.irDc;
+    }
+    if (sum.sII > 0 && sum.sRR > 0 && sum.redDc > 0) {
+      out->confidence = sum.sRI * sum.sRI * fastRecip(sum.sII * sum.sRR);
+      float ratio = sum.sRI * sum.irDc * fastRecip(sum.sII * sum.redDc);
+      float value = maximSpo2Curve(ratio);
+      if (out->confidence >= MW_MIN_CONFIDENCE && ratio > 0 && value >= 70) {
+        out->spo2 = (int32_t)(value + 0.5f);
+        out->validSpo2 = 1;
+      }
+    }
+  }
+
+  // HR from the beats that closed inside the window. Noise detected as
+  // beats comes at scattered intervals or, once it fires at every chance,
+  // just past the detector's refractory time with a random shape. A beat
+  // is regular when its interval, rise time, width and amplitude all agree
+  // with the medians, and the rate only counts when most beats are. The
+  // rhythm is judged over the window's own beats, so a short window follows
+  // a rate change once its span has; when it holds too few beats to tell,
+  // it reaches back to MW_RHYTHM_BEATS. A window reports no rate before it
+  // has filled.
+  uint32_t span = (uint32_t)(seconds * sampleRate);
+  if (samples < span) return out->validSpo2;
+  uint32_t start = samples - span;
+  uint16_t ibi[MW_MAX_BEATS], rise[MW_MAX_BEATS], width[MW_MAX_BEATS];
+  float amplitude[MW_MAX_BEATS];
+  uint8_t beats = 0, inWindow = 0;
+  uint32_t oldest = beatCount > MW_MAX_BEATS ? beatCount - MW_MAX_BEATS : 0;
+  for (uint32_t k = beatCount; k > oldest; k--) {
+    uint32_t slot = (k - 1) % MW_MAX_BEATS;
+    bool inside = (int32_t)(beatFoot[slot] + beatIbi[slot] * sampleRate / 1000 - start) >= 0;
+    if (!inside && beats >= MW_RHYTHM_BEATS) break;
+    ibi[beats] = beatIbi[slot];
+    rise[beats] = beatRise[slot];
+    width[beats] = beatWidth[slot];
+    amplitude[beats] = beatAmplitude[slot];
+    beats++;
+    if (inside) inWindow++;
+  }
+  if (inWindow < MW_MIN_BEATS || beats < MW_RHYTHM_BEATS) return out->validSpo2;
+
+  float ibiMedian = median(ibi, beats), riseMedian = median(rise, beats), widthMedian = median(width, beats);
+  float amplitudeMedian = median(amplitude, beats);
+  float slack = MW_SHAPE_SLACK * 1000.0f / sampleRate;
+  uint32_t ibiSum = 0;
+  uint8_t regular = 0, regularInWindow = 0;
+  for (uint8_t i = 0; i < beats; i++) {
+    if (fabsf(ibi[i] - ibiMedian) > MW_IBI_TOLERANCE * ibiMedian) continue;
+    if (fabsf(rise[i] - riseMedian) > MW_SHAPE_TOLERANCE * riseMedian + slack) continue;
+    if (fabsf(width[i] - widthMedian) > MW_SHAPE_TOLERANCE * widthMedian + slack) continue;
+    if (fabsf(amplitude[i] - amplitudeMedian) > MW_AMPLITUDE_TOLERANCE * amplitudeMedian) continue;
+    regular++;
+    if (i < inWindow) {
+      ibiSum += ibi[i];
+      regularInWindow++;
+    }
+  }
+  out->regularity = regular / (float)beats;
+  if (out->regularity >= MW_MIN_REGULAR && regularInWindow) {
+    out->heartRate = (int32_t)(60000.0f * regularInWindow / ibiSum + 0.5f);
+    out->validHeartRate = 1;
+  }
+  return out->validHeartRate || out->validSpo2;
+}
@@ -0,0 +1,57 @@
+#ifndef MULTI_WINDOW_H
+#define MULTI_WINDOW_H
+
+#include <Arduino.h>
+#include "regression_spo2.h"
+#include "pulse_morphology.h"
+
+// Concurrent HR/SpO2 estimates over several window lengths.
+// Nothing is filtered or detected twice: the filtered red/IR components
+// come from RegressionSpO2 and the beats from PulseMorphology. Per sample,
+// only one set of moment sums is accumulated into hop-sized blocks; a window
+// of any length is a sum over its blocks plus a scan of its beats, so each
+// extra window costs O(blocks + beats) per hop. A window HR needs a regular
+// rhythm of consistently shaped beats, which noise firing the beat detector
+// on a poorly perfused site doesn't have.
+
+#define MW_BLOCK_SAMPLES 25  // one hop
+#define MW_MAX_BLOCKS 48     // 12 s at 100 Hz
+#define MW_MAX_BEATS 32      // > 10 s at 190 bpm
+
+struct WindowEstimate {
+  int32_t heartRate;
+  int32_t spo2;
+  int8_t validHeartRate;
+  int8_t validSpo2;
+  float confidence;  // r^2 of the red/IR fit over the window
+  float regularity;  // fraction of recent beats near the median interval and rise time
+};
+
+class MultiWindowEstimator {
+public:
+  void begin(float sampleRate);
+  void addSample(const RegressionSpO2 &filtered);  // after filtered.addSample()
+  void addBeat(const BeatFeatures &beat);          // beats in sample-index order
+  bool estimate(float seconds, WindowEstimate *out) const;
+
+private:
+  struct Block {
+    float sII, sRI, sRR;  // AC cross-moments
+    float redDc, irDc;    // DC sums
+  };
+
+  float sampleRate;
+  uint32_t samples;      // samples seen; beat foot indices count the same way
+  Block blocks[MW_MAX_BLOCKS];
+  uint32_t blockCount;   // completed blocks
+  Block current;
+  uint8_t inCurrent;
+  uint32_t beatFoot[MW_MAX_BEATS];
+  uint16_t beatIbi[MW_MAX_BEATS];
+  uint16_t beatRise[MW_MAX_BEATS];
+  uint16_t beatWidth[MW_MAX_BEATS];
+  float beatAmplitude[MW_MAX_BEATS];
+  uint32_t beatCount;
+};
+
+#endif
@@ -0,0 +1,183 @@
+#include "nn_hr.h"
+#include "nn_hr_weights.h"
+
+#define NN_MIN_MARGIN 1  // best logit must beat the runner-up by this much
+
+const NnConvLayer nnConv1 = {nnConv1Weights, nnConv1Bias, NN_IN_CH, 8, 8, 4, NN_CONV1_MULT, NN_CONV1_SHIFT};
+const NnConvLayer nnConv2 = {nnConv2Weights, nnConv2Bias, 8, 16, 8, 2, NN_CONV2_MULT, NN_CONV2_SHIFT};
+const NnConvLayer nnConv3 = {nnConv3Weights, nnConv3Bias, 16, NN_FEATURES, 8, 2, NN_CONV3_MULT, NN_CONV3_SHIFT};
+
+// Ping-pong activation buffers, 16-byte aligned for the SIMD loads
+alignas(16) static int8_t nnInput[NN_WINDOW * NN_IN_CH];
+alignas(16) static int8_t nnAct1[NN_CONV1_LEN * 8];
+alignas(16) static int8_t nnAct2[NN_CONV2_LEN * 16];
+alignas(16) static int8_t nnAct3[NN_CONV3_LEN * NN_FEATURES];
+alignas(16) static int8_t nnPooled[NN_FEATURES];
+
+int32_t nnDotS8Portable(const int8_t *a, const int8_t *b, uint16_t len) {
+  int32_t acc = 0;
+  for (uint16_t i = 0; i < len; i++) acc += (int32_t)a[i] * b[i];
+  return acc;
+}
+
+#if NN_USE_PIE
+// 16 int8 MACs per instruction into the 40-bit ACCX accumulator. Operands
+// must be 16-byte aligned and len a multiple of 16 (the layer shapes ensure it).
+static int32_t nnDotS8Pie(const int8_t *a, const int8_t *b, uint16_t len) {
+  int32_t acc;
+  uint32_t blocks = len >> 4;
+  asm volatile(
+    "ee.zero.accx\n"
+    "1:\n"
+    "ee.vld.128.ip q0, %[a], 16\n"
+    "ee.vld.128.ip q1, %[b], 16\n"
+    "ee.vmulas.s8.accx q0, q1\n"
+    "addi %[n], %[n], -1\n"
+    "bnez %[n], 1b\n"
+    "rur.accx_0 %[acc]\n"
+    : [a] "+r"(a), [b] "+r"(b), [n] "+r"(blocks), [acc] "=r"(acc)
+    :
+    : "memory");
+  return acc;
+}
+#endif
+
+int32_t nnDotS8(const int8_t *a, const int8_t *b, uint16_t len) {
+#if NN_USE_PIE
+  if (len >= 16 && !(len & 15) && !(((uintptr_t)a | (uintptr_t)b) & 15)) return nnDotS8Pie(a, b, len);
+#endif
+  return nnDotS8Portable(a, b, len);
+}
+
+bool nnSelfTest() {
+  alignas(16) int8_t a[128];
+  alignas(16) int8_t b[128];
+  uint32_t seed = 12345;
+  for (uint16_t i = 0; i < sizeof(a); i++) {
+    seed = seed * 1103515245 + 12345;
+    a[i] = (int8_t)(seed >> 16);
+    b[i] = (int8_t)(seed >> 24);
+  }
+  a[0] = b[0] = -128;  // extremes
+  for (uint16_t len = 16; len <= sizeof(a); len += 16)
+    if (nnDotS8(a, b, len) != nnDotS8Portable(a, b, len)) return false;
+  return true;
+}
+
+static inline int8_t requantRelu(int32_t acc, const NnConvLayer &layer) {
+  int64_t v = ((int64_t)acc * layer.multiplier + ((int64_t)1 << (layer.shift - 1))) >> layer.shift;
+  if (v < 0) return 0;
+  if (v > 127) return 127;
+  return (int8_t)v;
+}
+
+void nnConv1d(const int8_t *in, const NnConvLayer &layer, int8_t *out, uint16_t outLen) {
+  uint16_t span = layer.kernel * layer.inCh;
+  for (uint16_t p = 0; p < outLen; p++) {
+    const int8_t *window = in + p * layer.stride * layer.inCh;
+    for (uint8_t oc = 0; oc < layer.outCh; oc++) {
+      int32_t acc = layer.bias[oc] + nnDotS8(window, layer.weights + oc * span, span);
+      *out++ = requantRelu(acc, layer);
+    }
+  }
+}
+
+void NnHR::begin(const SampleRing *r) {
+  ring = r;
+}
+
+size_t NnHR::memoryBytes() {
+  return sizeof(nnInput) + sizeof(nnAct1) + sizeof(nnAct2) + sizeof(nnAct3) + sizeof(nnPooled)
+         + sizeof(nnConv1Weights) + sizeof(nnConv2Weights) + sizeof(nnConv3Weights) + sizeof(nnDenseWeights)
+         + sizeof(nnConv1Bias) + sizeof(nnConv2Bias) + sizeof(nnConv3Bias) + sizeof(nnDenseBias);
+}
+
+static inline int32_t inputSample(const SampleRing *ring, uint8_t ch, uint32_t n, const int16_t *accel, uint16_t i) {
+  if (ch == 0) return ring->red(n);
+  if (ch == 1) return ring->ir(n);
+  if (ch == 2) return accel ? accel[i] : 0;
+#if PPG_CHANNELS >= 3
+  return ring->at(CH_GREEN, n);  // green fills the spare input channel
+#else
+  return 0;
+#endif
+}
+
+// Per-window, per-channel quantization: remove the mean and scale the
+// largest excursion to +-127. Integer only, so host and device agree.
+void NnHR::loadInput(const int16_t *accel) {
+  uint32_t start = ring->count() - NN_WINDOW;
+  for (uint8_t ch = 0; ch < NN_IN_CH; ch++) {
+    int64_t sum = 0;
+    for (uint16_t i = 0; i < NN_WINDOW; i++) sum += inputSample(ring, ch, start + i, accel, i);
+    int32_t mean = (int32_t)(sum / NN_WINDOW);
+
+    int32_t peak = 1;
+    for (uint16_t i = 0; i < NN_WINDOW; i++) {
+      int32_t d = abs(inputSample(ring, ch, start + i, accel, i) - mean);
+      if (d > peak) peak = d;
+    }
+    for (uint16_t i = 0; i < NN_WINDOW; i++) {
+      int32_t x = inputSample(ring, ch, start + i, accel, i) - mean;
+      nnInput[i * NN_IN_CH + ch] = (int8_t)((int64_t)x * 127 / peak);
+    }
+  }
+}
+
+// Global average pool over time (activations are 0..127 after ReLU)
+void nnAveragePool(const int8_t *in, uint16_t len, uint8_t channels, int8_t *out) {
+  for (uint8_t ch = 0; ch < channels; ch++) {
+    int32_t sum = 0;
+    for (uint16_t p = 0; p < len; p++) sum += in[p * channels + ch];
+    out[ch] = (int8_t)(sum / len);
+  }
+}
+
+void nnDense(const int8_t *in, uint8_t inLen, const int8_t *weights, const int32_t *bias, uint8_t outLen,
+             int32_t *out) {
+  for (uint8_t c = 0; c < outLen; c++) out[c] = bias[c] + nnDotS8(in, weights + c * inLen, inLen);
+}
+
+// nnInput to logits
+static void forward(int32_t logits[NN_CLASSES]) {
+  nnConv1d(nnInput, nnConv1, nnAct1, NN_CONV1_LEN);
+  nnConv1d(nnAct1, nnConv2, nnAct2, NN_CONV2_LEN);
+  nnConv1d(nnAct2, nnConv3, nnAct3, NN_CONV3_LEN);
+  nnAveragePool(nnAct3, NN_CONV3_LEN, NN_FEATURES, nnPooled);
+  nnDense(nnPooled, NN_FEATURES, nnDenseWeights, nnDenseBias, NN_CLASSES, logits);
+}
+
+// The input pattern only matters to the weights, not to the cost: every
+// layer runs the same dot products whatever the values
+uint32_t nnBenchmark() {
+  for (uint16_t i = 0; i < sizeof(nnInput); i++) nnInput[i] = (int8_t)(i * 37);
+  int32_t logits[NN_CLASSES];
+  uint32_t start = ESP.getCycleCount();
+  forward(logits);
+  return ESP.getCycleCount() - start;
+}
+
+bool NnHR::estimate(int32_t *heartRate, int8_t *validHeartRate, const int16_t *accel) {
+  *validHeartRate = 0;
+  if (ring->count() < NN_WINDOW) return false;
+
+  loadInput(accel);
+  int32_t logits[NN_CLASSES];
+  forward(logits);
+
+  uint8_t best = 0, second = 1;
+  for (uint8_t c = 1; c < NN_CLASSES; c++)
+    if (logits[c] > logits[best]) best = c;
+  for (uint8_t c = 0; c < NN_CLASSES; c++)
+    if (c != best && (second == best || logits[c] > logits[second])) second = c;
+
+  float bpm = NN_MIN_BPM + best * NN_STEP_BPM;
+  if (best > 0 && best < NN_CLASSES - 1) {
+    float l = logits[best - 1], m = logits[best], r = logits[best + 1];
+    float den = l - 2.0f * m + r;
+    if (den < 0) bpm += 0.5f * (l - r) / den * NN_STEP_BPM;
+  }
+  *heartRate = (int32_t)(bpm + 0.5f);
+  *validHeartRate = NN_WEIGHTS_TRAINED && logits[best] - logits[second] >= NN_MIN_MARGIN;
+  return *validHeartRate;
+}
@@ -0,0 +1,77 @@
+#ifndef NN_HR_H
+#define NN_HR_H
+
+#include <Arduino.h>
+#include "sample_ring.h"
+
+// Int8-quantized 1D-CNN HR estimator.
+// Input is the last NN_WINDOW samples of red/IR (plus an optional
+// accelerometer channel), quantized per window. Activations are stored
+// time-major ([t][ch]) and weights as [oc][k][ic], so the receptive field of
+// each output is one contiguous run of bytes and every conv output is a
+// single dot product: no im2col buffer. On the ESP32-S3 the dot product uses
+// the PIE 128-bit MAC unit; elsewhere a portable loop gives the same result
+// bit for bit (integer accumulation only).
+
+#define NN_WINDOW 512   // 5.12 s at 100 Hz
+#define NN_IN_CH 4      // red, IR, accel magnitude, green or padding (keeps rows 16-byte aligned)
+#define NN_MIN_BPM 40
+#define NN_STEP_BPM 5
+#define NN_CLASSES 33   // 40..200 bpm in 5 bpm classes
+#define NN_FEATURES 16  // conv3 channels, pooled into the dense layer
+
+// Valid (unpadded) conv lengths: kernel 8, strides 4, 2, 2
+#define NN_CONV1_LEN ((NN_WINDOW - 8) / 4 + 1)     // 127
+#define NN_CONV2_LEN ((NN_CONV1_LEN - 8) / 2 + 1)  // 60
+#define NN_CONV3_LEN ((NN_CONV2_LEN - 8) / 2 + 1)  // 27
+
+// Set with a trained, int8-exported nn_hr_weights.h. Until then the sketch
+// compiles the engine out of the loop; the kernels still self-test at boot.
+#ifndef NN_WEIGHTS_TRAINED
+#define NN_WEIGHTS_TRAINED 0
+#endif
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && !defined(NN_NO_PIE)
+#define NN_USE_PIE 1
+#else
+#define NN_USE_PIE 0
+#endif
+
+struct NnConvLayer {
+  const int8_t *weights;  // [outCh][kernel][inCh]
+  const int32_t *bias;    // [outCh], in accumulator scale
+  uint8_t inCh, outCh, kernel, stride;
+  int32_t multiplier;     // requantization: out = (acc * multiplier) >> shift
+  uint8_t shift;
+};
+
+int32_t nnDotS8(const int8_t *a, const int8_t *b, uint16_t len);
+int32_t nnDotS8Portable(const int8_t *a, const int8_t *b, uint16_t len);
+bool nnSelfTest();  // SIMD vs portable kernel agreement
+
+// Layers of the network, and the kernels that run them. Activations are
+// time-major; conv outputs are requantized and ReLU'd to 0..127.
+extern const NnConvLayer nnConv1, nnConv2, nnConv3;
+void nnConv1d(const int8_t *in, const NnConvLayer &layer, int8_t *out, uint16_t outLen);
+void nnAveragePool(const int8_t *in, uint16_t len, uint8_t channels, int8_t *out);
+void nnDense(const int8_t *in, uint8_t inLen, const int8_t *weights, const int32_t *bias, uint8_t outLen,
+             int32_t *out);
+
+// Cycles for one forward pass, whatever weights are compiled in; runs with
+// the placeholder weights too, so latency is known before training
+uint32_t nnBenchmark();
+
+class NnHR {
+public:
+  void begin(const SampleRing *ring);
+  // accel: optional NN_WINDOW accelerometer magnitudes aligned with the ring, or NULL
+  bool estimate(int32_t *heartRate, int8_t *validHeartRate, const int16_t *accel = NULL);
+  static size_t memoryBytes();  // activations + weights
+
+private:
+  void loadInput(const int16_t *accel);
+
+  const SampleRing *ring;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef NN_HR_WEIGHTS_H
+#define NN_HR_WEIGHTS_H
+
+// Weights for the NnHR network, stored in flash.
+// conv1: 4 -> 8, k8, s4   conv2: 8 -> 16, k8, s2   conv3: 16 -> 16, k8, s2
+// global average pool, dense: 16 -> NN_CLASSES (int32 logits)
+//
+// Placeholder: all zero until a trained, int8-exported model is dropped in
+// (then set NN_WEIGHTS_TRAINED in nn_hr.h). The estimate is never valid
+// with these, and the sketch skips the inference.
+
+alignas(16) static const int8_t nnConv1Weights[8 * 8 * 4] = {0};
+static const int32_t nnConv1Bias[8] = {0};
+#define NN_CONV1_MULT 1073741824
+#define NN_CONV1_SHIFT 38
+
+alignas(16) static const int8_t nnConv2Weights[16 * 8 * 8] = {0};
+static const int32_t nnConv2Bias[16] = {0};
+#define NN_CONV2_MULT 1073741824
+#define NN_CONV2_SHIFT 38
+
+alignas(16) static const int8_t nnConv3Weights[16 * 8 * 16] = {0};
+static const int32_t nnConv3Bias[16] = {0};
+#define NN_CONV3_MULT 1073741824
+#define NN_CONV3_SHIFT 38
+
+alignas(16) static const int8_t nnDenseWeights[NN_CLASSES * 16] = {0};
+static const int32_t nnDenseBias[NN_CLASSES] = {0};
+
+#endif
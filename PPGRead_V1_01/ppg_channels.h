@@ -0,0 +1,30 @@
+#ifndef PPG_CHANNELS_H
+#define PPG_CHANNELS_H
+
+#include <Arduino.h>
+
+// Channel profile, fixed at compile time so per-sample loops over channels
+// have a constant trip count and no per-sample branching.
+
+#ifndef PPG_CHANNELS
+#define PPG_CHANNELS 2  // 2: red + IR, 3: red + IR + green (MAX30101 class)
+#endif
+
+#define CH_RED 0
+#define CH_IR 1
+#define CH_GREEN 2
+
+// Channel the HR engines read: green tracks wrist HR best when it is fitted
+#if PPG_CHANNELS >= 3
+#define PPG_HR_CHANNEL CH_GREEN
+#else
+#define PPG_HR_CHANNEL CH_IR
+#endif
+
+// Ambient cancellation: subtract the LED-off slot from every channel of one
+// sample in place, clamped at zero
+static inline void cancelAmbient(uint32_t *sample, uint32_t ambient) {
+  for (uint8_t ch = 0; ch < PPG_CHANNELS; ch++) sample[ch] = sample[ch] > ambient ? sample[ch] - ambient : 0;
+}
+
+#endif
@@ -0,0 +1,155 @@
+#include "profiler.h"
+#if defined(__XTENSA__)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#if __has_include(<xtensa_context.h>)
+#include <xtensa_context.h>  // IDF 5
+#else
+#include <freertos/xtensa_context.h>
+#endif
+#endif
+
+volatile uint8_t profileStage;
+TraceBuffer loopTrace(1);
+
+static const char *const stageNames[PROFILE_STAGES] = {
+  "idle", "acquire", "autocorr", "maxim", "goertzel", "tracker", "regression",
+  "nn", "template", "windows", "fusion", "output", "store"
+};
+
+static hw_timer_t *timer;
+static uint32_t ringPc[PROFILE_RING];
+static uint8_t ringStage[PROFILE_RING];
+static volatile uint16_t head, tail;
+static volatile uint32_t droppedCount, sampleCount, cycleCount;
+static uint32_t rate;
+static bool headerDue;
+
+const char *profileStageName(uint8_t stage) {
+  return stage < PROFILE_STAGES ? stageNames[stage] : "?";
+}
+
+void profilePrintStages(Print &out) {
+  for (uint8_t s = 0; s < PROFILE_STAGES; s++) {
+    out.print("PROFILE stage ");
+    out.print(s);
+    out.print(" ");
+    out.println(stageNames[s]);
+  }
+}
+
+// PC the timer interrupted. By the time the IDF dispatcher calls us, EPC1
+// may no longer hold it: a window overflow anywhere in the dispatch chain is
+// a level-1 exception and overwrites EPC1. The dispatcher saved the real PC
+// in an interrupt frame on the task's stack and recorded that frame as the
+// task's top of stack (_frxt_int_enter). A level-1 timer cannot nest inside
+// another level-1 handler, so the frame always belongs to the current task.
+static inline uint32_t IRAM_ATTR interruptedPc() {
+#if defined(__XTENSA__)
+  // pxTopOfStack is the first member of the TCB
+  const XtExcFrame *frame = *(const XtExcFrame *const *)xTaskGetCurrentTaskHandle();
+  return frame->pc;
+#else
+  return 0;
+#endif
+}
+
+static void IRAM_ATTR onProfileTimer() {
+  uint32_t start = ESP.getCycleCount();
+  uint32_t pc = interruptedPc();
+  uint16_t next = (head + 1) & (PROFILE_RING - 1);
+  if (next == tail) {
+    droppedCount++;
+  } else {
+    ringPc[head] = pc;
+    ringStage[head] = profileStage;
+    head = next;
+  }
+  sampleCount++;
+  cycleCount += ESP.getCycleCount() - start;
+}
+
+bool Profiler::begin(uint32_t hz) {
+  head = tail = 0;
+  droppedCount = sampleCount = cycleCount = 0;
+  rate = hz;
+  headerDue = true;
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  timer = timerBegin(1000000);
+  if (!timer) return false;
+  timerAttachInterrupt(timer, &onProfileTimer);
+  timerAlarm(timer, 1000000 / hz, true, 0);
+#else
+  timer = timerBegin(0, 80, true);  // 1 MHz
+  if (!timer) return false;
+  timerAttachInterrupt(timer, &onProfileTimer, true);
+  timerAlarmWrite(timer, 1000000 / hz, true);
+  timerAlarmEnable(timer);
+#endif
+  return true;
+}
+
+void Profiler::end() {
+  if (!timer) return;
+  timerEnd(timer);
+  timer = NULL;
+}
+
+uint32_t Profiler::dropped() const {
+  return droppedCount;
+}
+
+float Profiler::isrCycles() const {
+  return sampleCount ? cycleCount / (float)sampleCount : 0;
+}
+
+bool Profiler::dumpTo(Print &out, uint16_t maxLines) {
+  if (head == tail) return false;
+  if (headerDue) {
+    // Stage table once, so the host needs nothing but the log and the ELF
+    out.print("PROFILE hz ");
+    out.println(rate);
+    profilePrintStages(out);
+    headerDue = false;
+  }
+  for (uint16_t line = 0; line < maxLines && tail != head; line++) {
+    out.print("S,");
+    out.print(ringPc[tail], HEX);
+    out.print(",");
+    out.println(ringStage[tail]);
+    tail = (tail + 1) & (PROFILE_RING - 1);
+  }
+  return head != tail;
+}
+
+bool TraceBuffer::push(uint32_t us, uint8_t stage) {
+  uint16_t next = (head + 1) & (TRACE_RING - 1);
+  if (next == tail) return false;
+  eventUs[head] = us;
+  eventStage[head] = stage;
+  head = next;
+  return true;
+}
+
+void TraceBuffer::record(uint8_t stage) {
+  uint32_t now = micros();
+  // After an overflow, mark the hole so the host doesn't draw a span across it
+  if (lost) {
+    if (!push(now, TRACE_GAP)) return;
+    lost = false;
+  }
+  if (!push(now, stage)) lost = true;
+}
+
+bool TraceBuffer::dumpTo(Print &out, uint16_t maxLines) {
+  for (uint16_t line = 0; line < maxLines && tail != head; line++) {
+    out.print("T,");
+    out.print(tid);
+    out.print(",");
+    out.print(eventUs[tail]);
+    out.print(",");
+    out.println(eventStage[tail]);
+    tail = (tail + 1) & (TRACE_RING - 1);
+  }
+  return head != tail;
+}
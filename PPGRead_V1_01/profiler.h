@@ -0,0 +1,83 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+
+// Sampling profiler.
+// A hardware timer interrupts PROFILE_HZ times a second and records the
+// interrupted PC (from the interrupt frame the IDF dispatcher saved) together
+// with the pipeline stage the sketch last entered. Samples go into a ring that is drained over serial a few lines
+// per loop, like the raw capture export, and symbolized on the host against
+// the ELF (tools/profile_symbolize.py). The cycle counter times the ISR itself
+// so the profiler reports its own overhead.
+//
+// With PROFILE_TRACE, every stage switch is also timestamped into a trace
+// buffer owned by the thread that makes it (the loop task here). Each buffer
+// has one writer and is drained by the same thread, so no locking is needed.
+// Lines are T,<tid>,<us>,<stage>; tools/trace_to_chrome.py turns them into
+// Chrome trace-event JSON with one span per stage.
+
+#define PROFILE_RING 1024  // samples, power of two
+#define TRACE_RING 512     // stage switches per thread, power of two
+
+#ifndef PROFILE_TRACE
+#define PROFILE_TRACE 0  // 1: record timestamped stage switches
+#endif
+
+#define PROFILE_STAGE_IDLE 0      // delay() and anything untagged
+#define PROFILE_STAGE_ACQUIRE 1   // FIFO reads and per-sample engines
+#define PROFILE_STAGE_AUTOCORR 2
+#define PROFILE_STAGE_MAXIM 3
+#define PROFILE_STAGE_GOERTZEL 4
+#define PROFILE_STAGE_TRACKER 5
+#define PROFILE_STAGE_REGRESSION 6
+#define PROFILE_STAGE_NN 7
+#define PROFILE_STAGE_TEMPLATE 8
+#define PROFILE_STAGE_WINDOWS 9
+#define PROFILE_STAGE_FUSION 10
+#define PROFILE_STAGE_OUTPUT 11   // serial prints and display
+#define PROFILE_STAGE_STORE 12    // tracks and flash log
+#define PROFILE_STAGES 13
+#define TRACE_GAP 0xFF  // events were lost before this point
+
+class TraceBuffer {
+public:
+  explicit TraceBuffer(uint8_t tid) : tid(tid) {}
+  void record(uint8_t stage);
+  // Emit up to maxLines events; returns true while events remain
+  bool dumpTo(Print &out, uint16_t maxLines);
+
+private:
+  bool push(uint32_t us, uint8_t stage);
+
+  uint8_t tid;
+  uint32_t eventUs[TRACE_RING];
+  uint8_t eventStage[TRACE_RING];
+  volatile uint16_t head, tail;
+  bool lost;
+};
+
+extern volatile uint8_t profileStage;
+extern TraceBuffer loopTrace;
+
+// Tag the work that follows; it stays tagged until the next call
+inline void profileEnter(uint8_t stage) {
+  profileStage = stage;
+#if PROFILE_TRACE
+  loopTrace.record(stage);
+#endif
+}
+const char *profileStageName(uint8_t stage);
+void profilePrintStages(Print &out);  // stage table for the host tools
+
+class Profiler {
+public:
+  bool begin(uint32_t hz);
+  void end();
+  // Emit up to maxLines queued samples as S,<pc hex>,<stage>; returns true while samples remain
+  bool dumpTo(Print &out, uint16_t maxLines);
+  uint32_t dropped() const;
+  float isrCycles() const;  // average cycles spent in the ISR per sample
+};
+
+#endif
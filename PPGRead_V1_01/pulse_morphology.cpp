@@ -0,0 +1,143 @@
+#include "pulse_morphology.h"
+
+#define MORPH_DC_TAU 1.5f           // s
+#define MORPH_LP_CUTOFF 8.0f        // Hz, keeps the dicrotic notch
+#define MORPH_SLOPE_DECAY 0.998f    // per sample
+#define MORPH_SLOPE_THRESHOLD 0.5f  // fraction of slopeMax that marks an upstroke
+#define MORPH_FOOT_SEARCH 0.25f     // s before the upstroke
+#define MORPH_MIN_BEAT 0.3f         // s (200 bpm)
+#define MORPH_MAX_BEAT 1.5f         // s (40 bpm)
+#define MORPH_TEMPLATE_WEIGHT 0.1f  // EMA share of each new beat
+
+void PulseTemplate::reset() {
+  memset(shape, 0, sizeof(shape));
+  count = 0;
+}
+
+void PulseTemplate::update(const float *beat, float amplitude, float weight) {
+  if (amplitude <= 0) return;
+  float w = count == 0 ? 1.0f : weight;
+  for (uint8_t i = 0; i < PULSE_TEMPLATE_LEN; i++) shape[i] += w * (beat[i] / amplitude - shape[i]);
+  if (count < 0xFFFF) count++;
+}
+
+void PulseMorphology::begin(float fs) {
+  sampleRate = fs;
+  dcAlpha = 1.0f - expf(-1.0f / (MORPH_DC_TAU * fs));
+  lpAlpha = 1.0f - expf(-2.0f * PI * MORPH_LP_CUTOFF / fs);
+  init = false;
+  n = 0;
+  slopeMax = 0;
+  armed = true;
+  lastUpstroke = 0;
+  haveFoot = false;
+  queueHead = queueCount = 0;
+  droppedBeats = 0;
+  tpl.reset();
+}
+
+void PulseMorphology::seedDc(float level) {
+  dc = level;
+  lp = 0;
+  init = true;
+}
+
+bool PulseMorphology::addSample(uint32_t ir) {
+  if (!init) {
+    dc = ir;
+    lp = 0;
+    init = true;
+  }
+  // Blood volume raises absorption, so the pulse is the inverted IR AC
+  dc += dcAlpha * ((float)ir - dc);
+  lp += lpAlpha * ((dc - (float)ir) - lp);
+  history[n & (MORPH_HISTORY - 1)] = lp;
+  n++;
+  if (n < 2) return false;
+
+  float slope = at(n - 1) - at(n - 2);
+  slopeMax *= MORPH_SLOPE_DECAY;
+  if (slope > slopeMax) slopeMax = slope;
+  if (slope < 0) armed = true;
+
+  bool produced = false;
+  uint32_t minBeat = (uint32_t)(MORPH_MIN_BEAT * sampleRate);
+  if (armed && slope > MORPH_SLOPE_THRESHOLD * slopeMax && n - lastUpstroke > minBeat) {
+    armed = false;
+    lastUpstroke = n;
+
+    // Foot: walk back down the upstroke to the first local minimum
+    uint32_t search = (uint32_t)(MORPH_FOOT_SEARCH * sampleRate);
+    uint32_t foot = n - 1;
+    while (foot > 0 && n - foot < search && at(foot - 1) <= at(foot)) foot--;
+
+    if (haveFoot && foot - lastFoot >= minBeat && foot - lastFoot <= (uint32_t)(MORPH_MAX_BEAT * sampleRate)) {
+      closeBeat(lastFoot, foot);
+      produced = true;
+    }
+    lastFoot = foot;
+    haveFoot = true;
+  }
+  return produced;
+}
+
+void PulseMorphology::closeBeat(uint32_t foot, uint32_t nextFoot) {
+  BeatFeatures beat;
+  float msPerSample = 1000.0f / sampleRate;
+  beat.footIndex = foot;
+  beat.ibiMs = (uint16_t)((nextFoot - foot) * msPerSample);
+
+  uint32_t peak = foot;
+  for (uint32_t k = foot; k < nextFoot; k++)
+    if (at(k) > at(peak)) peak = k;
+  float base = at(foot);
+  beat.amplitude = at(peak) - base;
+  beat.riseMs = (uint16_t)((peak - foot) * msPerSample);
+
+  uint16_t above = 0;
+  float half = base + 0.5f * beat.amplitude;
+  for (uint32_t k = foot; k < nextFoot; k++)
+    if (at(k) >= half) above++;
+  beat.widthMs = (uint16_t)(above * msPerSample);
+
+  // Dicrotic notch: first local minimum on the downslope, before the last
+  // quarter of the beat (the next upstroke's foot region)
+  beat.notchMs = 0;
+  beat.notchRatio = 0;
+  uint32_t end = nextFoot - (nextFoot - foot) / 4;
+  for (uint32_t k = peak + 1; k + 1 < end; k++) {
+    if (!(at(k) < at(k - 1) && at(k) <= at(k + 1))) continue;
+    beat.notchMs = (uint16_t)((k - foot) * msPerSample);
+    beat.notchRatio = beat.amplitude > 0 ? (at(k) - base) / beat.amplitude : 0;
+    break;
+  }
+
+  push(beat);
+
+  // Fold into the ensemble template, aligned on the foot; short beats are
+  // held at their closing value rather than running into the next one
+  float aligned[PULSE_TEMPLATE_LEN];
+  for (uint8_t i = 0; i < PULSE_TEMPLATE_LEN; i++) {
+    uint32_t k = foot - PULSE_TEMPLATE_PRE + i;
+    aligned[i] = at(k < nextFoot ? k : nextFoot) - base;
+  }
+  tpl.update(aligned, beat.amplitude, MORPH_TEMPLATE_WEIGHT);
+}
+
+void PulseMorphology::push(const BeatFeatures &beat) {
+  if (queueCount == MORPH_QUEUE_LEN) {
+    queueHead = (queueHead + 1) % MORPH_QUEUE_LEN;  // drop the oldest
+    queueCount--;
+    droppedBeats++;
+  }
+  queue[(queueHead + queueCount) % MORPH_QUEUE_LEN] = beat;
+  queueCount++;
+}
+
+bool PulseMorphology::pop(BeatFeatures *beat) {
+  if (queueCount == 0) return false;
+  *beat = queue[queueHead];
+  queueHead = (queueHead + 1) % MORPH_QUEUE_LEN;
+  queueCount--;
+  return true;
+}
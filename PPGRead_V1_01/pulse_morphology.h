@@ -0,0 +1,78 @@
+#ifndef PULSE_MORPHOLOGY_H
+#define PULSE_MORPHOLOGY_H
+
+#include <Arduino.h>
+
+// Streaming beat segmentation and pulse-wave morphology features.
+// Feet are found from the upstroke of the filtered (inverted) IR pulse; when
+// a beat closes, its features go into a bounded queue (oldest dropped) and
+// the beat is folded into an ensemble-averaged template in place.
+
+#define MORPH_HISTORY 256     // filtered samples kept, power of two (> longest beat + search)
+#define MORPH_QUEUE_LEN 16    // beat records buffered for consumers
+#define PULSE_TEMPLATE_LEN 48  // samples per template, starting PULSE_TEMPLATE_PRE before the foot
+#define PULSE_TEMPLATE_PRE 6
+
+// Fixed-size per-beat record
+struct BeatFeatures {
+  uint32_t footIndex;  // sample index of the foot (onset)
+  uint16_t ibiMs;      // foot to next foot
+  uint16_t riseMs;     // foot to systolic peak
+  uint16_t widthMs;    // time above half amplitude
+  uint16_t notchMs;    // foot to dicrotic notch, 0 if none found
+  float amplitude;     // peak minus foot, IR counts
+  float notchRatio;    // notch height over amplitude
+};
+
+// Ensemble average of amplitude-normalized beats aligned on the foot
+class PulseTemplate {
+public:
+  void reset();
+  // beat holds PULSE_TEMPLATE_LEN samples; weight is the new beat's share (EMA)
+  void update(const float *beat, float amplitude, float weight);
+  const float *data() const { return shape; }
+  uint16_t beats() const { return count; }
+
+private:
+  float shape[PULSE_TEMPLATE_LEN];
+  uint16_t count;
+};
+
+class PulseMorphology {
+public:
+  void begin(float sampleRate);
+  bool addSample(uint32_t ir);  // true when a beat record was produced
+  void seedDc(float level);     // start from a known baseline (checkpoint restore)
+  float dcLevel() const { return dc; }
+  bool pop(BeatFeatures *beat);  // oldest queued record
+  uint8_t queued() const { return queueCount; }
+  uint32_t dropped() const { return droppedBeats; }
+  const PulseTemplate &pulseTemplate() const { return tpl; }
+
+  // Filtered pulse history, shared with downstream beat detectors
+  uint32_t samples() const { return n; }
+  float at(uint32_t n) const { return history[n & (MORPH_HISTORY - 1)]; }
+
+private:
+  void closeBeat(uint32_t foot, uint32_t nextFoot);
+  void push(const BeatFeatures &beat);
+
+  float sampleRate;
+  float dcAlpha, lpAlpha;
+  bool init;
+  float dc, lp;
+  float history[MORPH_HISTORY];  // filtered pulse, upstroke positive
+  uint32_t n;                    // samples seen
+  float slopeMax;                // decaying max of the upstroke slope
+  bool armed;                    // slope went negative since the last upstroke
+  uint32_t lastUpstroke;
+  uint32_t lastFoot;
+  bool haveFoot;
+
+  BeatFeatures queue[MORPH_QUEUE_LEN];
+  uint8_t queueHead, queueCount;
+  uint32_t droppedBeats;
+  PulseTemplate tpl;
+};
+
+#endif
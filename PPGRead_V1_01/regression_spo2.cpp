@@ -0,0 +1,72 @@
+#include "regression_spo2.h"
+#include "fast_math.h"
+
+#define REG_SPO2_DC_TAU 1.5f         // s, baseline tracker
+#define REG_SPO2_AC_HIGHPASS 0.5f    // Hz, drift removal (2 poles), below 40 bpm
+#define REG_SPO2_AC_CUTOFF 5.0f      // Hz, AC smoothing
+#define REG_SPO2_MIN_CONFIDENCE 0.7f
+#define REG_SPO2_MIN_PERFUSION 1e-7f  // IR AC power relative to DC^2 (~0.03% rms)
+
+void RegressionSpO2::begin(float fs, float tauSec) {
+  dcAlpha = 1.0f - expf(-1.0f / (REG_SPO2_DC_TAU * fs));
+  hpAlpha = 1.0f - expf(-2.0f * PI * REG_SPO2_AC_HIGHPASS / fs);
+  acAlpha = 1.0f - expf(-2.0f * PI * REG_SPO2_AC_CUTOFF / fs);
+  momentAlpha = 1.0f - expf(-1.0f / (tauSec * fs));
+  init = false;
+  lastConfidence = 0;
+  lastRatio = 0;
+}
+
+void RegressionSpO2::seedDc(float red, float ir) {
+  redDc = red;
+  irDc = ir;
+  redLow1 = irLow1 = redLow2 = irLow2 = 0;
+  redAc = irAc = 0;
+  sRR = sRI = sII = 0;
+  init = true;
+}
+
+void RegressionSpO2::addSample(uint32_t red, uint32_t ir) {
+  if (!init) {
+    redDc = red;
+    irDc = ir;
+    redAc = irAc = 0;
+    sRR = sRI = sII = 0;
+    init = true;
+  }
+  redDc += dcAlpha * ((float)red - redDc);
+  irDc += dcAlpha * ((float)ir - irDc);
+  float redHp = (float)red - redDc, irHp = (float)ir - irDc;
+  redLow1 += hpAlpha * (redHp - redLow1);
+  irLow1 += hpAlpha * (irHp - irLow1);
+  redHp -= redLow1;
+  irHp -= irLow1;
+  redLow2 += hpAlpha * (redHp - redLow2);
+  irLow2 += hpAlpha * (irHp - irLow2);
+  redHp -= redLow2;
+  irHp -= irLow2;
+  redAc += acAlpha * (redHp - redAc);
+  irAc += acAlpha * (irHp - irAc);
+
+  sRR += momentAlpha * (redAc * redAc - sRR);
+  sRI += momentAlpha * (redAc * irAc - sRI);
+  sII += momentAlpha * (irAc * irAc - sII);
+}
+
+bool RegressionSpO2::estimate(int32_t *spo2, int8_t *validSpo2) {
+  *validSpo2 = 0;
+  lastConfidence = 0;
+  if (!init || sII <= 0 || sRR <= 0 || redDc <= 0) return false;
+
+  lastConfidence = sRI * sRI * fastRecip(sRR * sII);
+  if (sII < REG_SPO2_MIN_PERFUSION * irDc * irDc) return false;
+
+  // Slope of red AC vs IR AC, rescaled by the DC levels: (ACr/DCr) / (ACir/DCir)
+  lastRatio = sRI * irDc * fastRecip(sII * redDc);
+  float value = maximSpo2Curve(lastRatio);
+
+  if (lastConfidence < REG_SPO2_MIN_CONFIDENCE || lastRatio <= 0 || value < 70) return false;
+  *spo2 = (int32_t)(value + 0.5f);
+  *validSpo2 = 1;
+  return true;
+}
@@ -0,0 +1,50 @@
+#ifndef REGRESSION_SPO2_H
+#define REGRESSION_SPO2_H
+
+#include <Arduino.h>
+
+// Ratio-of-ratios SpO2 from a least-squares fit of red AC against IR AC.
+// Exponentially weighted cross-moments are updated in O(1) per sample, so a
+// value is available every hop without detecting peaks or valleys. The fit
+// correlation (r^2) doubles as the confidence score.
+//
+// The AC path is band-passed (two high-pass poles, then smoothing) after
+// the baseline is removed: drift the baseline tracker lags behind is common
+// to red and IR and would pull R towards 1. Both channels see the same
+// filter, so the slope of the pulse itself is unchanged.
+
+// Maxim calibration curve from ratio of ratios to SpO2 %, capped at 100
+inline float maximSpo2Curve(float ratio) {
+  float value = -45.060f * ratio * ratio + 30.354f * ratio + 94.845f;
+  return value > 100 ? 100 : value;
+}
+
+class RegressionSpO2 {
+public:
+  // tauSec is the memory of the moments (effective window length)
+  void begin(float sampleRate, float tauSec = 3.0f);
+  void addSample(uint32_t red, uint32_t ir);
+  bool estimate(int32_t *spo2, int8_t *validSpo2);
+  float confidence() const { return lastConfidence; }  // 0..1, r^2 of the fit
+  float ratio() const { return lastRatio; }            // R of the last estimate
+
+  // Filtered signals of the latest sample, shared with other estimators
+  float redDcLevel() const { return redDc; }
+  float irDcLevel() const { return irDc; }
+  float redAcLevel() const { return redAc; }
+  float irAcLevel() const { return irAc; }
+
+  // Start from known baselines (checkpoint restore) instead of the first sample
+  void seedDc(float red, float ir);
+
+private:
+  float dcAlpha, hpAlpha, acAlpha, momentAlpha;
+  bool init;
+  float redDc, irDc;   // baseline trackers
+  float redLow1, irLow1, redLow2, irLow2;  // high-pass stages of the AC path
+  float redAc, irAc;   // smoothed AC components
+  float sRR, sRI, sII;  // weighted cross-moments of the AC components
+  float lastConfidence, lastRatio;
+};
+
+#endif
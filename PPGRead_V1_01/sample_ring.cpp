@@ -0,0 +1,23 @@
+#include "sample_ring.h"
+
+void SampleRing::begin(BatchPool *p) {
+  pool = p;
+  head = 0;
+  for (uint16_t i = 0; i < SAMPLE_RING_BLOCKS; i++) {
+    blocks[i] = pool->acquire();
+    memset(blocks[i], 0, sizeof(SampleBatch));
+  }
+}
+
+// The new block is taken before the old one is dropped, so a failed
+// acquire leaves the ring as it was
+bool SampleRing::open() {
+  SampleBatch *fresh = pool->acquire();
+  if (!fresh) return false;
+  fresh->firstIndex = head;
+  fresh->count = 0;
+  uint32_t index = blockIndex(head);
+  pool->release(blocks[index]);
+  blocks[index] = fresh;
+  return true;
+}
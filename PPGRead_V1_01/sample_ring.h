@@ -0,0 +1,79 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <Arduino.h>
+#include "ppg_channels.h"
+#include "batch_pool.h"
+
+// Shared sample history. Samples are addressed by their absolute index
+// (0 = first sample ever pushed), so engines can keep their own read
+// position and catch up on whatever arrived since their last update.
+//
+// The history is a ring of batch pool blocks, each holding BATCH_SAMPLES
+// consecutive samples. Acquisition writes every sample once, in place, into
+// the open block (claim() and commit()), and all engines read it there; no
+// stage copies it. Opening a block takes a fresh one from the pool and
+// drops the ring's reference to the block it replaces, so a consumer that
+// retained that block (batch()) keeps it intact. At least
+// SAMPLE_RING_SIZE - BATCH_SAMPLES samples of history are always readable.
+
+#define SAMPLE_RING_SIZE 1024  // power of two, ~10 s at 100 Hz
+#define SAMPLE_RING_MASK (SAMPLE_RING_SIZE - 1)
+#define SAMPLE_RING_BLOCKS (SAMPLE_RING_SIZE / BATCH_SAMPLES)
+
+static_assert(SAMPLE_RING_SIZE % BATCH_SAMPLES == 0, "ring holds whole blocks");
+static_assert(BATCH_POOL_BLOCKS > SAMPLE_RING_BLOCKS, "pool holds the ring plus the block it opens");
+
+class SampleRing {
+public:
+  // Takes SAMPLE_RING_BLOCKS zeroed blocks from the pool
+  void begin(BatchPool *pool);
+
+  // Slot for the next sample in the open block, PPG_CHANNELS wide; NULL if
+  // a block was due and the pool had none. commit() publishes it.
+  uint32_t *claim() {
+    uint32_t slot = head % BATCH_SAMPLES;
+    if (slot == 0 && !open()) return NULL;
+    return blocks[blockIndex(head)]->samples[slot];
+  }
+  void commit() {
+    blocks[blockIndex(head)]->count++;
+    head++;
+  }
+  // Copying write, for sources that don't fill the slot in place
+  bool push(const uint32_t *sample) {
+    uint32_t *slot = claim();
+    if (!slot) return false;
+    for (uint8_t ch = 0; ch < PPG_CHANNELS; ch++) slot[ch] = sample[ch];
+    commit();
+    return true;
+  }
+
+  uint32_t count() const { return head; }  // total samples pushed
+  const uint32_t *sample(uint32_t n) const { return blocks[blockIndex(n)]->samples[n % BATCH_SAMPLES]; }
+  uint32_t at(uint8_t ch, uint32_t n) const { return sample(n)[ch]; }
+  uint32_t red(uint32_t n) const { return at(CH_RED, n); }
+  uint32_t ir(uint32_t n) const { return at(CH_IR, n); }
+  uint32_t hr(uint32_t n) const { return at(PPG_HR_CHANNEL, n); }
+  // Block holding sample n; retain it to keep the samples past their eviction
+  const SampleBatch *batch(uint32_t n) const { return blocks[blockIndex(n)]; }
+
+  // Copy the newest len samples into linear buffers, oldest first
+  void copyLatest(uint32_t *red, uint32_t *ir, uint16_t len) const {
+    uint32_t start = head - len;
+    for (uint16_t i = 0; i < len; i++) {
+      red[i] = this->red(start + i);
+      ir[i] = this->ir(start + i);
+    }
+  }
+
+private:
+  static uint32_t blockIndex(uint32_t n) { return (n / BATCH_SAMPLES) % SAMPLE_RING_BLOCKS; }
+  bool open();
+
+  BatchPool *pool;
+  SampleBatch *blocks[SAMPLE_RING_BLOCKS];
+  uint32_t head;
+};
+
+#endif
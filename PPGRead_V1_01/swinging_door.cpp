@@ -0,0 +1,75 @@
+#include "swinging_door.h"
+
+void SwingingDoor::begin(float dev, uint32_t span) {
+  deviation = dev;
+  maxSpanMs = span;
+  active = false;
+  gap = false;
+  haveLast = false;
+  inputCount = archivedCount = 0;
+}
+
+// Archive the last sample on the middle slope and restart from it
+uint8_t SwingingDoor::closeSegment(TrackPoint *out) {
+  if (!active || !haveLast) return 0;
+  out->ms = lastMs;
+  out->value = anchorValue + 0.5f * (upper + lower) * (lastMs - anchorMs);
+  out->valid = true;
+  anchorMs = lastMs;
+  anchorValue = out->value;
+  haveLast = false;
+  archivedCount++;
+  return 1;
+}
+
+uint8_t SwingingDoor::add(uint32_t ms, float value, bool valid, TrackPoint *out) {
+  inputCount++;
+
+  if (!valid) {
+    if (gap) return 0;
+    uint8_t n = closeSegment(out);
+    out[n].ms = ms;
+    out[n].value = 0;
+    out[n].valid = false;
+    active = false;
+    gap = true;
+    archivedCount++;
+    return n + 1;
+  }
+
+  if (!active) {
+    active = true;
+    gap = false;
+    haveLast = false;
+    anchorMs = ms;
+    anchorValue = value;
+    out->ms = ms;
+    out->value = value;
+    out->valid = true;
+    archivedCount++;
+    return 1;
+  }
+
+  uint8_t n = 0;
+  float dt = ms - anchorMs;
+  float up = (value + deviation - anchorValue) / dt;
+  float low = (value - deviation - anchorValue) / dt;
+  float newUpper = haveLast && upper < up ? upper : up;
+  float newLower = haveLast && lower > low ? lower : low;
+  if (haveLast && (newLower > newUpper || ms - anchorMs > maxSpanMs)) {
+    n = closeSegment(out);
+    dt = ms - anchorMs;
+    upper = (value + deviation - anchorValue) / dt;
+    lower = (value - deviation - anchorValue) / dt;
+  } else {
+    upper = newUpper;
+    lower = newLower;
+  }
+  lastMs = ms;
+  haveLast = true;
+  return n;
+}
+
+uint8_t SwingingDoor::flush(TrackPoint *out) {
+  return closeSegment(out);  // the next sample opens fresh doors from here
+}
@@ -0,0 +1,44 @@
+#ifndef SWINGING_DOOR_H
+#define SWINGING_DOOR_H
+
+#include <Arduino.h>
+
+// Swinging-door compression of a vitals track for long-term storage.
+// From each archived anchor, every new sample narrows an upper and a lower
+// "door" (the slopes that still pass within +-deviation of it). When the doors
+// cross, the segment is closed at the previous sample on the middle slope,
+// which lies inside every door, so linear interpolation between archived
+// points stays within the deviation of every input. Invalid stretches are
+// archived as a single gap point; segments are also closed after maxSpanMs
+// so a reader never has to look back further than that.
+
+struct TrackPoint {
+  uint32_t ms;
+  float value;
+  bool valid;  // false marks the start of a gap
+};
+
+class SwingingDoor {
+public:
+  void begin(float deviation, uint32_t maxSpanMs);
+  // Returns the number of points archived into out[0..1]
+  uint8_t add(uint32_t ms, float value, bool valid, TrackPoint *out);
+  uint8_t flush(TrackPoint *out);  // close the open segment, e.g. before sleep
+  uint32_t inputs() const { return inputCount; }
+  uint32_t archived() const { return archivedCount; }
+
+private:
+  uint8_t closeSegment(TrackPoint *out);
+
+  float deviation;
+  uint32_t maxSpanMs;
+  bool active;       // a segment is open at the anchor
+  bool gap;          // the gap point was archived
+  uint32_t anchorMs, lastMs;
+  float anchorValue;
+  bool haveLast;     // at least one sample after the anchor
+  float upper, lower;  // door slopes, per ms
+  uint32_t inputCount, archivedCount;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#include "telemetry.h"
+
+void VitalsTelemetry::begin(const TelemetryConfig &cfg) {
+  config = cfg;
+  first = true;
+  lastMs = 0;
+  lastHeartRate = lastSpo2 = 0;
+  lastValidHeartRate = lastValidSpo2 = 0;
+  sentCount = suppressedCount = 0;
+}
+
+bool VitalsTelemetry::update(uint32_t nowMs, int32_t heartRate, int8_t validHeartRate, int32_t spo2, int8_t validSpo2, Print &out) {
+  uint32_t elapsed = nowMs - lastMs;
+  char reason = 0;
+  if (first || validHeartRate != lastValidHeartRate || validSpo2 != lastValidSpo2) {
+    reason = TELEMETRY_REASON_VALIDITY;  // a dropout or recovery always goes out
+  } else if ((validHeartRate && abs(heartRate - lastHeartRate) >= config.hrDeadband)
+             || (validSpo2 && abs(spo2 - lastSpo2) >= config.spo2Deadband)) {
+    if (elapsed >= config.minIntervalMs) reason = TELEMETRY_REASON_CHANGE;
+  } else if (elapsed >= config.keepAliveMs) {
+    reason = TELEMETRY_REASON_KEEPALIVE;
+  }
+  if (!reason) {
+    suppressedCount++;
+    return false;
+  }
+
+  out.print("V,");
+  out.print(nowMs);
+  out.print(",");
+  if (validHeartRate) out.print(heartRate);
+  out.print(",");
+  if (validSpo2) out.print(spo2);
+  out.print(",");
+  out.println(reason);
+
+  first = false;
+  lastMs = nowMs;
+  lastHeartRate = heartRate;
+  lastSpo2 = spo2;
+  lastValidHeartRate = validHeartRate;
+  lastValidSpo2 = validSpo2;
+  sentCount++;
+  return true;
+}
@@ -0,0 +1,44 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+// Delta-only vitals telemetry.
+// Fused HR/SpO2 are reported only when one moves past its dead-band, its
+// validity changes, or nothing was sent for the keep-alive time; a minimum
+// interval caps the rate during fast changes. Lines look like
+//   V,<ms>,<hr>,<spo2>,<reason>
+// with an empty field for an invalid value, and hold until the next line.
+// Raw streaming (C, lines from EventCapture) is independent of this. The
+// per-hop engine and fused log lines are DEBUG, so from LOG_LEVEL_INFO up
+// the only other vitals on the port are the archived track points (P,).
+
+#define TELEMETRY_REASON_CHANGE 'C'
+#define TELEMETRY_REASON_VALIDITY 'V'
+#define TELEMETRY_REASON_KEEPALIVE 'K'
+
+struct TelemetryConfig {
+  uint8_t hrDeadband;       // bpm
+  uint8_t spo2Deadband;     // %
+  uint16_t minIntervalMs;   // rate limit for changes
+  uint16_t keepAliveMs;     // report unchanged vitals this often
+};
+
+class VitalsTelemetry {
+public:
+  void begin(const TelemetryConfig &config);
+  // Once per hop; returns true if a line was written
+  bool update(uint32_t nowMs, int32_t heartRate, int8_t validHeartRate, int32_t spo2, int8_t validSpo2, Print &out);
+  uint32_t sent() const { return sentCount; }
+  uint32_t suppressed() const { return suppressedCount; }
+
+private:
+  TelemetryConfig config;
+  bool first;
+  uint32_t lastMs;
+  int32_t lastHeartRate, lastSpo2;
+  int8_t lastValidHeartRate, lastValidSpo2;
+  uint32_t sentCount, suppressedCount;
+};
+
+#endif
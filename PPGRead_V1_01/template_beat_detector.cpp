@@ -0,0 +1,127 @@
+#include "template_beat_detector.h"
+#include "fast_math.h"
+
+#define TEMPLATE_SEED_BEATS 4       // morphology beats needed before matching starts
+#define TEMPLATE_DETECT_NCC 0.6f    // correlation peak that counts as a beat
+#define TEMPLATE_LEARN_NCC 0.8f     // only clean matches refine the template
+#define TEMPLATE_LEARN_WEIGHT 0.05f
+#define TEMPLATE_MIN_BEAT 0.3f      // s (200 bpm)
+#define TEMPLATE_MAX_BEAT 1.5f      // s (40 bpm)
+
+void TemplateBeatDetector::begin(const PulseMorphology *src, float fs) {
+  source = src;
+  sampleRate = fs;
+  next = source->samples();
+  tpl.reset();
+  ready = false;
+  ncc1 = ncc2 = lastNcc = 0;
+  haveBeat = false;
+  ibiHead = ibiCount = 0;
+  beatCount = 0;
+}
+
+void TemplateBeatDetector::adopt(const PulseTemplate &t) {
+  tpl = t;
+  const float *shape = tpl.data();
+  float mean = 0;
+  for (uint8_t i = 0; i < PULSE_TEMPLATE_LEN; i++) mean += shape[i];
+  mean /= PULSE_TEMPLATE_LEN;
+  float energy = 0;
+  for (uint8_t i = 0; i < PULSE_TEMPLATE_LEN; i++) {
+    tplCentered[i] = shape[i] - mean;
+    energy += tplCentered[i] * tplCentered[i];
+  }
+  ready = energy > 0;
+  if (!ready) return;
+  float norm = fastRsqrt(energy);
+  for (uint8_t i = 0; i < PULSE_TEMPLATE_LEN; i++) tplCentered[i] *= norm;
+}
+
+float TemplateBeatDetector::correlate(uint32_t end) {
+  uint32_t start = end - PULSE_TEMPLATE_LEN + 1;
+  float sum = 0, sumSq = 0, dot = 0;
+  for (uint8_t i = 0; i < PULSE_TEMPLATE_LEN; i++) {
+    float x = source->at(start + i);
+    sum += x;
+    sumSq += x * x;
+    dot += x * tplCentered[i];  // template is zero-mean, so the window mean drops out
+  }
+  float var = sumSq - sum * sum / PULSE_TEMPLATE_LEN;
+  return var > 0 ? dot * fastRsqrt(var) : 0;
+}
+
+// Beat-synchronous ensemble averaging: fold the matched window in, scaled to
+// unit peak like the morphology template, so weak beats shape the template
+// as much as strong ones
+void TemplateBeatDetector::learn(uint32_t start, float ncc) {
+  if (ncc < TEMPLATE_LEARN_NCC) return;
+  float window[PULSE_TEMPLATE_LEN];
+  float base = source->at(start + PULSE_TEMPLATE_PRE);
+  float peak = 0;
+  for (uint8_t i = 0; i < PULSE_TEMPLATE_LEN; i++) {
+    window[i] = source->at(start + i) - base;
+    if (window[i] > peak) peak = window[i];
+  }
+  PulseTemplate updated = tpl;
+  updated.update(window, peak, TEMPLATE_LEARN_WEIGHT);
+  adopt(updated);
+}
+
+bool TemplateBeatDetector::update() {
+  bool detected = false;
+  uint32_t minBeat = (uint32_t)(TEMPLATE_MIN_BEAT * sampleRate);
+  uint32_t maxBeat = (uint32_t)(TEMPLATE_MAX_BEAT * sampleRate);
+
+  while (next != source->samples()) {
+    uint32_t n = next++;
+    if (!ready) {
+      // Seed from the peak-picked ensemble while the signal is still strong
+      if (source->pulseTemplate().beats() >= TEMPLATE_SEED_BEATS) adopt(source->pulseTemplate());
+      continue;
+    }
+    if (n < PULSE_TEMPLATE_LEN) continue;
+
+    float ncc = correlate(n);
+    // Local maximum one sample back; the foot sits PULSE_TEMPLATE_PRE into the window
+    if (ncc1 > TEMPLATE_DETECT_NCC && ncc1 >= ncc2 && ncc1 > ncc) {
+      uint32_t start = n - PULSE_TEMPLATE_LEN;
+      uint32_t foot = start + PULSE_TEMPLATE_PRE;
+      if (!haveBeat || foot - lastBeat >= minBeat) {
+        if (haveBeat && foot - lastBeat <= maxBeat) {
+          ibi[ibiHead] = foot - lastBeat;
+          ibiHead = (ibiHead + 1) % TEMPLATE_IBI_COUNT;
+          if (ibiCount < TEMPLATE_IBI_COUNT) ibiCount++;
+        }
+        lastBeat = foot;
+        haveBeat = true;
+        beatCount++;
+        lastNcc = ncc1;
+        learn(start, ncc1);
+        detected = true;
+      }
+    }
+    ncc2 = ncc1;
+    ncc1 = ncc;
+  }
+  return detected;
+}
+
+bool TemplateBeatDetector::estimate(int32_t *heartRate, int8_t *validHeartRate) {
+  *validHeartRate = 0;
+  if (ibiCount < TEMPLATE_IBI_COUNT / 2) return false;
+  if (next - lastBeat > 2 * (uint32_t)(TEMPLATE_MAX_BEAT * sampleRate)) return false;  // lost the pulse
+
+  // Median interval, robust to the odd missed or extra beat
+  uint16_t sorted[TEMPLATE_IBI_COUNT];
+  memcpy(sorted, ibi, ibiCount * sizeof(uint16_t));
+  for (uint8_t i = 1; i < ibiCount; i++)
+    for (uint8_t j = i; j > 0 && sorted[j - 1] > sorted[j]; j--) {
+      uint16_t t = sorted[j];
+      sorted[j] = sorted[j - 1];
+      sorted[j - 1] = t;
+    }
+  uint16_t median = sorted[ibiCount / 2];
+  *heartRate = (int32_t)(60.0f * sampleRate / median + 0.5f);
+  *validHeartRate = 1;
+  return true;
+}
@@ -0,0 +1,44 @@
+#ifndef TEMPLATE_BEAT_DETECTOR_H
+#define TEMPLATE_BEAT_DETECTOR_H
+
+#include <Arduino.h>
+#include "pulse_morphology.h"
+
+// Beat detection by template matching, for low perfusion.
+// Slides a beat-synchronous ensemble-averaged pulse template over the
+// filtered pulse shared by PulseMorphology and detects beats at peaks of the
+// normalized cross-correlation. Averaging across beats raises the template
+// SNR without lengthening the analysis window. Cost is O(PULSE_TEMPLATE_LEN)
+// per sample.
+
+#define TEMPLATE_IBI_COUNT 8  // intervals kept for the HR median
+
+class TemplateBeatDetector {
+public:
+  void begin(const PulseMorphology *source, float sampleRate);
+  bool update();  // consume new filtered samples, true if a beat was detected
+  bool estimate(int32_t *heartRate, int8_t *validHeartRate);
+  uint32_t beats() const { return beatCount; }
+  float lastCorrelation() const { return lastNcc; }
+
+private:
+  float correlate(uint32_t end);  // NCC of the template against samples ending at end
+  void adopt(const PulseTemplate &t);
+  void learn(uint32_t start, float ncc);
+
+  const PulseMorphology *source;
+  float sampleRate;
+  uint32_t next;  // next filtered sample to consume
+  PulseTemplate tpl;
+  float tplCentered[PULSE_TEMPLATE_LEN];  // zero-mean, unit-energy copy of tpl
+  bool ready;
+  float ncc1, ncc2;  // NCC one and two samples back
+  float lastNcc;
+  uint32_t lastBeat;
+  bool haveBeat;
+  uint16_t ibi[TEMPLATE_IBI_COUNT];  // samples
+  uint8_t ibiHead, ibiCount;
+  uint32_t beatCount;
+};
+
+#endif
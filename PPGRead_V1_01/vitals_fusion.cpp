@@ -0,0 +1,89 @@
+#include "vitals_fusion.h"
+
+#define KALMAN_GATE_SIGMA2 9  // reject innovations beyond 3 sigma
+
+// HR: 2 bpm/hop drift, 3 bpm engine noise, valid while within 10 bpm
+#define HR_PROCESS_VAR (4 * KALMAN_ONE)
+#define HR_MEASURE_VAR (9 * KALMAN_ONE)
+#define HR_VALID_VAR (100 * KALMAN_ONE)
+#define HR_MAX_VAR (2500 * KALMAN_ONE)
+
+// SpO2: 1 point/hop drift, 2 point engine noise, valid while within 4 points
+#define SPO2_PROCESS_VAR (1 * KALMAN_ONE)
+#define SPO2_MEASURE_VAR (4 * KALMAN_ONE)
+#define SPO2_VALID_VAR (16 * KALMAN_ONE)
+#define SPO2_MAX_VAR (400 * KALMAN_ONE)
+
+void ScalarKalman::begin(int32_t q, int32_t r, int32_t validLimit, int32_t cap) {
+  processVar = q;
+  measureVar = r;
+  validVar = validLimit;
+  maxVar = cap;
+  x = 0;
+  p = cap;
+  init = false;
+}
+
+void ScalarKalman::predict(uint32_t hops) {
+  int64_t grown = p + (int64_t)processVar * hops;
+  p = grown > maxVar ? maxVar : (int32_t)grown;
+}
+
+bool ScalarKalman::update(int32_t measurement, uint8_t quality) {
+  if (quality == 0) return false;
+  int64_t r = (int64_t)measureVar * 255 / quality;
+  if (r > maxVar) r = maxVar;
+  int32_t z = measurement << 16;
+
+  if (!init) {
+    x = z;
+    p = (int32_t)r;
+    init = true;
+    return true;
+  }
+
+  int64_t innov = (int64_t)z - x;
+  int64_t s = p + r;
+  // Gate only a confident state, so a coasting one can re-acquire
+  if (valid() && innov * innov > KALMAN_GATE_SIGMA2 * s * KALMAN_ONE) return false;
+
+  int64_t k = ((int64_t)p << 16) / s;  // Q16.16 gain
+  x += (int32_t)((k * innov) >> 16);
+  p = (int32_t)(((KALMAN_ONE - k) * p) >> 16);
+  return true;
+}
+
+bool ScalarKalman::getState(int32_t *state, int32_t *var) const {
+  *state = x;
+  *var = p;
+  return init;
+}
+
+void ScalarKalman::restore(int32_t state, int32_t var) {
+  x = state;
+  p = var > maxVar ? maxVar : var;
+  init = true;
+}
+
+void VitalsFusion::begin() {
+  hr.begin(HR_PROCESS_VAR, HR_MEASURE_VAR, HR_VALID_VAR, HR_MAX_VAR);
+  spo2.begin(SPO2_PROCESS_VAR, SPO2_MEASURE_VAR, SPO2_VALID_VAR, SPO2_MAX_VAR);
+}
+
+void VitalsFusion::predict() {
+  hr.predict();
+  spo2.predict();
+}
+
+bool VitalsFusion::heartRate(int32_t *bpm) const {
+  if (!hr.valid()) return false;
+  *bpm = hr.value();
+  return true;
+}
+
+bool VitalsFusion::oxygenSaturation(int32_t *percent) const {
+  if (!spo2.valid()) return false;
+  int32_t v = spo2.value();
+  *percent = v > 100 ? 100 : v;
+  return true;
+}
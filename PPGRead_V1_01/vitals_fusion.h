@@ -0,0 +1,55 @@
+#ifndef VITALS_FUSION_H
+#define VITALS_FUSION_H
+
+#include <Arduino.h>
+
+// Fixed-point Kalman fusion of HR/SpO2 estimates.
+// Each vital is a scalar random-walk state in Q16.16. Every hop the
+// variance grows by the process noise; each available engine estimate is a
+// measurement whose variance is its base variance scaled by 1/quality.
+// Outliers far outside the predicted spread are gated out. Through
+// dropouts the state coasts on its last value until the variance passes the
+// validity limit. One update is a handful of integer ops and one division.
+
+#define KALMAN_ONE 65536  // 1.0 in Q16.16
+
+class ScalarKalman {
+public:
+  // Variances in units^2, Q16.16: per-hop process noise, measurement noise at
+  // full quality, the largest variance still reported valid, and a cap
+  void begin(int32_t processVar, int32_t measureVar, int32_t validVar, int32_t maxVar);
+  void predict(uint32_t hops = 1);
+  bool update(int32_t measurement, uint8_t quality);  // quality 1..255, false if gated
+  bool valid() const { return init && p <= validVar; }
+  int32_t value() const { return (x + KALMAN_ONE / 2) >> 16; }
+  int32_t variance() const { return p; }  // Q16.16
+
+  // Checkpoint support, raw Q16.16 state
+  bool getState(int32_t *state, int32_t *var) const;
+  void restore(int32_t state, int32_t var);
+
+private:
+  int32_t x, p;  // state and variance, Q16.16
+  int32_t processVar, measureVar, validVar, maxVar;
+  bool init;
+};
+
+class VitalsFusion {
+public:
+  void begin();
+  void predict();  // once per hop, before the updates
+  void addHeartRate(int32_t bpm, uint8_t quality) { hr.update(bpm, quality); }
+  void addSpo2(int32_t percent, uint8_t quality) { spo2.update(percent, quality); }
+  bool heartRate(int32_t *bpm) const;
+  bool oxygenSaturation(int32_t *percent) const;
+  const ScalarKalman &heartRateState() const { return hr; }
+  const ScalarKalman &spo2State() const { return spo2; }
+  ScalarKalman &heartRateState() { return hr; }
+  ScalarKalman &spo2State() { return spo2; }
+
+private:
+  ScalarKalman hr;
+  ScalarKalman spo2;
+};
+
+#endif
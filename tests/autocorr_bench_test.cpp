@@ -0,0 +1,94 @@
+// Autocorrelation engine on the shared ring: sub-bpm accuracy of the
+// refined peak on off-grid rates, few wrong (harmonic) peaks, and cost per hop of the incremental lag
+// sums against recomputing them over the window every hop.
+// sources: autocorr_hr.cpp sample_ring.cpp batch_pool.cpp
+#include "autocorr_hr.h"
+#include "host_test.h"
+
+#define FS 100
+#define HOP 25
+#define SECONDS 40
+#define SETTLE_SEC 10   // window adapts, not scored
+#define AMPLITUDE 1000  // counts
+#define NOISE 200       // counts, uniform
+#define GROSS_BPM 10    // an error this large is a wrong peak, not resolution
+
+static float errors[SECONDS * FS / HOP];
+
+static float median(float *v, uint32_t n) {
+  for (uint32_t i = 1; i < n; i++)
+    for (uint32_t j = i; j > 0 && v[j] < v[j - 1]; j--) {
+      float t = v[j];
+      v[j] = v[j - 1];
+      v[j - 1] = t;
+    }
+  return n ? v[n / 2] : 0;
+}
+
+static BatchPool pool;
+static SampleRing ring;
+
+// The naive alternative: every lag product over the current window
+static int64_t naiveLagSums(uint32_t newest, uint16_t window) {
+  int64_t total = 0;
+  for (uint16_t lag = AUTOCORR_MIN_LAG - 1; lag <= AUTOCORR_MAX_LAG; lag++) {
+    int64_t sum = 0;
+    for (uint32_t n = newest - window + 1; n <= newest; n++) sum += (int64_t)ring.hr(n) * ring.hr(n - lag);
+    total += sum;
+  }
+  return total;
+}
+
+int main() {
+  static const float rates[] = {45.5f, 61.3f, 73.7f, 98.2f, 131.4f, 166.6f, 190.1f};
+  uint64_t engineNanos = 0, naiveNanos = 0, worstHop = 0;
+  uint32_t hops = 0;
+  volatile int64_t sink = 0;
+  pool.begin();
+  ring.begin(&pool);
+  for (float bpm : rates) {
+    AutocorrHR autocorr;
+    autocorr.begin(&ring, FS);
+    HostPulse pulse;
+    uint32_t scored = 0, valid = 0, gross = 0;
+    float quantized[SECONDS * FS / HOP];
+    for (uint32_t n = 0; n < SECONDS * FS; n += HOP) {
+      for (uint32_t i = 0; i < HOP; i++) {
+        uint32_t sample[PPG_CHANNELS];
+        float x = AMPLITUDE * pulse.next(bpm, FS);
+        for (uint8_t ch = 0; ch < PPG_CHANNELS; ch++) sample[ch] = (uint32_t)(100000 - x + NOISE * hostNoise());
+        ring.push(sample);
+      }
+      uint64_t t0 = hostNanos();
+      autocorr.update();
+      int32_t hr;
+      int8_t ok;
+      autocorr.estimate(&hr, &ok);
+      uint64_t spent = hostNanos() - t0;
+      engineNanos += spent;
+      if (n >= SETTLE_SEC * FS && spent > worstHop) worstHop = spent;
+      hops++;
+      t0 = hostNanos();
+      sink = sink + naiveLagSums(ring.count() - 1, autocorr.window());
+      naiveNanos += hostNanos() - t0;
+
+      if (n < SETTLE_SEC * FS) continue;
+      scored++;
+      if (!ok) continue;
+      float lag = roundf(60.0f * FS / autocorr.bpm());  // the integer peak before refinement
+      quantized[valid] = fabsf(60.0f * FS / lag - bpm);
+      errors[valid++] = fabsf(autocorr.bpm() - bpm);
+      if (errors[valid - 1] > GROSS_BPM) gross++;
+    }
+    float medianError = median(errors, valid);
+    printf("%5.1f bpm: valid %3.0f%%, %u wrong peaks, median error %.2f bpm refined, %.2f bpm at integer lags\n",
+           bpm, 100.0f * valid / scored, gross, medianError, median(quantized, valid));
+    CHECK(valid >= scored * 9 / 10);
+    CHECK(gross * 20 <= valid);
+    CHECK(medianError < 1.0f);
+  }
+  printf("per hop: engine %.1f us (worst %.1f us), naive recompute %.1f us\n", engineNanos / 1000.0f / hops,
+         worstHop / 1000.0f, naiveNanos / 1000.0f / hops);
+  CHECK(engineNanos * 2 < naiveNanos);
+  return hostTestResult();
+}
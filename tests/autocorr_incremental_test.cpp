@@ -0,0 +1,42 @@
+// Incremental lag sums against a full recompute, across random resizes.
+// sources: autocorr_hr.cpp sample_ring.cpp batch_pool.cpp
+#define private public  // the sums are internal state
+#include "autocorr_hr.h"
+#undef private
+#include "host_test.h"
+
+#define TOTAL_SAMPLES 5000
+#define UPDATE_EVERY 25  // a hop
+
+static BatchPool pool;
+static SampleRing ring;
+
+int main() {
+  static const uint16_t lags[] = {0, AUTOCORR_MIN_LAG - 1, AUTOCORR_MIN_LAG, 77, AUTOCORR_MAX_LAG};
+  pool.begin();
+  ring.begin(&pool);
+  AutocorrHR autocorr;
+  autocorr.begin(&ring, 100);
+  uint32_t resizes = 0;
+  for (uint32_t n = 0; n < TOTAL_SAMPLES; n++) {
+    uint32_t sample[PPG_CHANNELS];
+    for (uint8_t ch = 0; ch < PPG_CHANNELS; ch++) sample[ch] = 100000 + hostRandom() % 1000;
+    ring.push(sample);
+    if (n % UPDATE_EVERY != UPDATE_EVERY - 1) continue;
+
+    autocorr.update();
+    if (hostRandom() % 3 == 0) {
+      autocorr.setWindow(AUTOCORR_MIN_WINDOW + hostRandom() % (AUTOCORR_MAX_WINDOW - AUTOCORR_MIN_WINDOW));
+      resizes++;
+    }
+    uint32_t newest = autocorr.next - 1;
+    for (uint16_t lag : lags) {
+      int64_t sum = 0;
+      for (uint32_t k = 0; k < autocorr.inWindow; k++) sum += (int64_t)ring.hr(newest - k) * ring.hr(newest - k - lag);
+      CHECK(sum == autocorr.lagSum[lag]);
+    }
+  }
+  CHECK(resizes > 0);
+  CHECK(autocorr.inWindow == autocorr.windowLen);
+  return hostTestResult();
+}
@@ -0,0 +1,179 @@
+// The batch pool under contention from host threads, the stand-in for the
+// two S3 cores and their ISRs (on a single-CPU host they interleave by
+// preemption instead). Every thread hammers acquire, retain and release
+// while holding up to HELD blocks, more than the pool has between them, and
+// checks that no block it holds is handed to anyone else. Then one producer
+// shares every block with several consumer threads: each is written once,
+// read by all of them, and recycled by whichever releases it last. Nothing
+// may be torn, lost or leaked.
+// sources: batch_pool.cpp
+#include "batch_pool.h"
+#include "host_test.h"
+#include <thread>
+
+#define THREADS 4
+#define ROUNDS 50000      // per thread
+#define HELD 10           // blocks each thread holds at once: 40, more than the pool has
+#define CONSUMERS 3
+#define BATCHES 100000    // produced
+#define QUEUE 64          // per consumer, power of two; deep enough to drain the pool
+#define SOLO_ROUNDS 2000000
+
+static BatchPool pool;
+
+struct Hammer {
+  uint32_t rounds = 0, acquired = 0, empty = 0, corrupted = 0;
+};
+
+// Acquire up to HELD blocks, stamp them with this thread and round, share
+// each with ourselves, yield so the others run, then check the stamps
+static void hammer(uint32_t id, Hammer *out) {
+  for (uint32_t round = 0; round < ROUNDS; round++) {
+    SampleBatch *held[HELD];
+    uint8_t count = 0;
+    for (; count < HELD; count++) {
+      held[count] = pool.acquire();
+      if (!held[count]) {
+        out->empty++;
+        break;
+      }
+      out->acquired++;
+      uint32_t stamp = id << 24 | (round & 0xFFFFFF);
+      held[count]->firstIndex = stamp;
+      held[count]->samples[BATCH_SAMPLES - 1][PPG_CHANNELS - 1] = stamp;
+      pool.retain(held[count]);
+    }
+    if (round % 64 == 0) std::this_thread::yield();
+    for (uint8_t i = 0; i < count; i++) {
+      uint32_t stamp = id << 24 | (round & 0xFFFFFF);
+      pool.release(held[i]);  // one reference left, still ours
+      if (held[i]->firstIndex != stamp || held[i]->samples[BATCH_SAMPLES - 1][PPG_CHANNELS - 1] != stamp)
+        out->corrupted++;
+      pool.release(held[i]);
+    }
+    out->rounds++;
+  }
+}
+
+// Single-producer single-consumer handoff of block pointers
+struct Queue {
+  const SampleBatch *slots[QUEUE];
+  std::atomic<uint32_t> head{0}, tail{0};
+};
+
+static Queue queues[CONSUMERS];
+
+static uint32_t checksum(const SampleBatch *batch) {
+  uint32_t sum = batch->firstIndex;
+  for (uint16_t i = 0; i < batch->count; i++)
+    for (uint8_t ch = 0; ch < PPG_CHANNELS; ch++) sum = sum * 31 + batch->samples[i][ch];
+  return sum;
+}
+
+struct Consumer {
+  uint32_t seen = 0, outOfOrder = 0, corrupted = 0;
+};
+
+static void consume(Queue *q, Consumer *out) {
+  uint32_t expect = 0;
+  while (expect < BATCHES) {
+    uint32_t tail = q->tail.load(std::memory_order_relaxed);
+    if (tail == q->head.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+      continue;
+    }
+    const SampleBatch *batch = q->slots[tail % QUEUE];
+    q->tail.store(tail + 1, std::memory_order_release);
+    if (batch->firstIndex != expect) out->outOfOrder++;
+    // The producer wrote the sample words from the index; checksum both ways
+    uint32_t want = batch->firstIndex;
+    for (uint16_t i = 0; i < batch->count; i++)
+      for (uint8_t ch = 0; ch < PPG_CHANNELS; ch++) want = want * 31 + (batch->firstIndex * BATCH_SAMPLES + i) * 4 + ch;
+    if (checksum(batch) != want) out->corrupted++;
+    pool.release(batch);
+    out->seen++;
+    expect = batch->firstIndex + 1;
+  }
+}
+
+static void produce(uint32_t *empty) {
+  for (uint32_t seq = 0; seq < BATCHES; seq++) {
+    SampleBatch *batch;
+    while (!(batch = pool.acquire())) {
+      (*empty)++;
+      std::this_thread::yield();
+    }
+    batch->firstIndex = seq;
+    batch->count = BATCH_SAMPLES;
+    for (uint16_t i = 0; i < BATCH_SAMPLES; i++)
+      for (uint8_t ch = 0; ch < PPG_CHANNELS; ch++) batch->samples[i][ch] = (seq * BATCH_SAMPLES + i) * 4 + ch;
+    for (Queue &q : queues) {
+      pool.retain(batch);
+      uint32_t head = q.head.load(std::memory_order_relaxed);
+      while (head - q.tail.load(std::memory_order_acquire) == QUEUE) std::this_thread::yield();
+      q.slots[head % QUEUE] = batch;
+      q.head.store(head + 1, std::memory_order_release);
+    }
+    pool.release(batch);  // the consumers hold it now
+  }
+}
+
+int main() {
+  // Uncontended cost of one acquire + release
+  pool.begin();
+  uint64_t start = hostNanos();
+  for (uint32_t i = 0; i < SOLO_ROUNDS; i++) pool.release(pool.acquire());
+  float solo = (float)(hostNanos() - start) / SOLO_ROUNDS;
+
+  // Everyone hammering at once
+  pool.begin();
+  Hammer hammers[THREADS];
+  std::thread threads[THREADS];
+  start = hostNanos();
+  for (uint32_t t = 0; t < THREADS; t++) threads[t] = std::thread(hammer, t + 1, &hammers[t]);
+  for (std::thread &t : threads) t.join();
+  uint64_t contendedNanos = hostNanos() - start;
+  uint32_t rounds = 0, acquired = 0, empty = 0, corrupted = 0;
+  for (const Hammer &h : hammers) {
+    rounds += h.rounds;
+    acquired += h.acquired;
+    empty += h.empty;
+    corrupted += h.corrupted;
+  }
+  float contended = (float)contendedNanos / acquired;  // with the retain, release pair and the checks
+  printf("%u threads on %u cpus: acquire + release %.1f ns solo, %.1f ns contended; %u empty, %u corrupted\n",
+         THREADS, std::thread::hardware_concurrency(), solo, contended, empty, corrupted);
+  CHECK(rounds == THREADS * ROUNDS);
+  CHECK(empty > 0);  // the pool did run dry
+  CHECK(corrupted == 0);
+  CHECK(pool.exhausted() == empty);
+  CHECK(pool.available() == BATCH_POOL_BLOCKS);
+  // A handful of atomics per call, no locks or syscalls
+  CHECK(solo < 200);
+
+  // One writer, every block shared read-only by all consumers
+  pool.begin();
+  Consumer consumers[CONSUMERS];
+  std::thread readers[CONSUMERS];
+  uint32_t producerEmpty = 0;
+  start = hostNanos();
+  for (uint32_t c = 0; c < CONSUMERS; c++) readers[c] = std::thread(consume, &queues[c], &consumers[c]);
+  std::thread writer(produce, &producerEmpty);
+  writer.join();
+  for (std::thread &t : readers) t.join();
+  float perBatch = (float)(hostNanos() - start) / BATCHES;
+  uint32_t seen = 0, outOfOrder = 0;
+  corrupted = 0;
+  for (const Consumer &c : consumers) {
+    seen += c.seen;
+    outOfOrder += c.outOfOrder;
+    corrupted += c.corrupted;
+  }
+  printf("%u batches to %u consumers: %.0f ns per batch, %u torn, %u out of order, producer found the pool empty %u times\n",
+         BATCHES, CONSUMERS, perBatch, corrupted, outOfOrder, producerEmpty);
+  CHECK(seen == BATCHES * CONSUMERS);
+  CHECK(corrupted == 0);
+  CHECK(outOfOrder == 0);
+  CHECK(pool.available() == BATCH_POOL_BLOCKS);  // the last reader of each recycled it
+  return hostTestResult();
+}
@@ -0,0 +1,130 @@
+// Per-sample throughput of acquisition, the shared ring and the sketch's
+// per-sample engines under the 2- and 3-channel profiles. The 3-channel
+// build compares itself with the 2-channel result the run left behind.
+// variants: -DPPG_CHANNELS=2 -DPPG_CHANNELS=3
+// sources: goertzel_hr.cpp regression_spo2.cpp pulse_morphology.cpp multi_window.cpp autocorr_hr.cpp fast_math.cpp sample_ring.cpp batch_pool.cpp
+#include "sample_ring.h"
+#include "goertzel_hr.h"
+#include "regression_spo2.h"
+#include "pulse_morphology.h"
+#include "multi_window.h"
+#include "autocorr_hr.h"
+#include "host_test.h"
+#include <stdlib.h>
+
+#define FS 100
+#define HOP 25
+#define SECONDS 60
+#define SAMPLES (SECONDS * FS)
+#define RUNS 40  // best of
+
+static uint32_t fifo[SAMPLES][3];  // red, IR, green slots as the sensor delivers them
+
+// The sketch's per-sample path: read the slots the profile uses into the
+// ring's open block, and feed the engines the HR channel and red/IR from it. The acquisition
+// and ring stage is the part that scales with the channel count; it is also
+// timed alone, against the whole path in the same process, since absolute
+// host timings move between processes.
+struct Pipeline {
+  BatchPool pool;
+  SampleRing ring;
+  GoertzelBank hrBank, spectrumBank;
+  RegressionSpO2 spo2;
+  PulseMorphology morphology;
+  MultiWindowEstimator windows;
+  AutocorrHR autocorr;
+
+  void begin() {
+    pool.begin();
+    ring.begin(&pool);
+    hrBank.begin(FS, 90, 2, 24);
+    spectrumBank.begin(FS, 120, 3, 54, 2.0f);
+    spo2.begin(FS);
+    morphology.begin(FS);
+    windows.begin(FS);
+    autocorr.begin(&ring, FS);
+  }
+
+  uint32_t run(bool engines) {
+    uint32_t beats = 0;
+    for (uint32_t n = 0; n < SAMPLES; n++) {
+      uint32_t *sample = ring.claim();
+      for (uint8_t ch = 0; ch < PPG_CHANNELS; ch++) sample[ch] = fifo[n][ch];
+      ring.commit();
+      if (!engines) continue;
+      uint32_t pulse = sample[PPG_HR_CHANNEL];
+      hrBank.addSample(pulse);
+      spectrumBank.addSample(pulse);
+      spo2.addSample(sample[CH_RED], sample[CH_IR]);
+      beats += morphology.addSample(pulse);
+      windows.addSample(spo2);
+      if (n % HOP == HOP - 1) autocorr.update();
+    }
+    return beats;
+  }
+};
+
+static Pipeline pipeline;
+
+static uint64_t timeRun(bool engines, uint32_t *beats) {
+  pipeline.begin();
+  uint64_t start = hostNanos();
+  *beats = pipeline.run(engines);
+  return hostNanos() - start;
+}
+
+int main() {
+  HostPulse pulse;
+  for (uint32_t n = 0; n < SAMPLES; n++) {
+    float ac = pulse.next(72, FS);
+    fifo[n][CH_RED] = (uint32_t)(60000 * (1 - 0.01f * ac) + 20 * hostNoise());
+    fifo[n][CH_IR] = (uint32_t)(100000 * (1 - 0.02f * ac) + 20 * hostNoise());
+    fifo[n][CH_GREEN] = (uint32_t)(30000 * (1 - 0.05f * ac) + 20 * hostNoise());
+  }
+
+  // Interleaved, best of each, so both see the same machine
+  uint64_t stageBest = UINT64_MAX, fullBest = UINT64_MAX;
+  uint32_t beats = 0, none;
+  for (int run = 0; run < RUNS; run++) {
+    uint64_t ns = timeRun(false, &none);
+    if (ns < stageBest) stageBest = ns;
+    ns = timeRun(true, &beats);
+    if (ns < fullBest) fullBest = ns;
+  }
+  float stage = (float)stageBest / SAMPLES, full = (float)fullBest / SAMPLES;
+  float share = stage / full;
+  printf("%d channels: %.1f ns/sample, acquisition and ring %.1f ns (%.1f%%), %u beats, ring blocks %u bytes\n",
+         PPG_CHANNELS, full, stage, share * 100, beats, (unsigned)(SAMPLE_RING_BLOCKS * sizeof(SampleBatch)));
+
+  // The engines read the profile's HR channel straight from the sample
+  CHECK(beats >= SECONDS * 72 / 60 - 3);
+  CHECK(pipeline.ring.hr(SAMPLES - 1) == fifo[SAMPLES - 1][PPG_HR_CHANNEL]);
+  CHECK(PPG_HR_CHANNEL == (PPG_CHANNELS >= 3 ? CH_GREEN : CH_IR));
+  CHECK(sizeof(SampleBatch) == PPG_CHANNELS * BATCH_SAMPLES * sizeof(uint32_t) + 8);
+
+  // Hand the 2-channel share to the 3-channel build of the same run
+  char path[256];
+  snprintf(path, sizeof(path), "%s/channel_throughput.%d", getenv("HOST_TEST_OUT") ?: "/tmp", PPG_CHANNELS);
+  if (FILE *f = fopen(path, "w")) {
+    fprintf(f, "%f\n", share);
+    fclose(f);
+  }
+#if PPG_CHANNELS >= 3
+  snprintf(path, sizeof(path), "%s/channel_throughput.2", getenv("HOST_TEST_OUT") ?: "/tmp");
+  float twoShare = 0;
+  if (FILE *f = fopen(path, "r")) {
+    if (fscanf(f, "%f", &twoShare) != 1) twoShare = 0;
+    fclose(f);
+  }
+  if (twoShare > 0) {
+    // Whole path relative to its engines, which do the same work either way
+    float ratio = (1 - twoShare) / (1 - share);
+    printf("3 vs 2 channels: %.3fx per sample\n", ratio);
+    // One more slot to copy and store, no per-sample branching
+    CHECK(ratio < 1.1f);
+  } else {
+    printf("no 2-channel result to compare with, run both variants\n");
+  }
+#endif
+  return hostTestResult();
+}
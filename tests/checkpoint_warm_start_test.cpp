@@ -0,0 +1,134 @@
+// Time to valid fused vitals, cold start against a timer wake from a
+// checkpoint, averaged over wakes at random pulse phases; and which boots
+// may use the RTC copy at all.
+// sources: checkpoint.cpp regression_spo2.cpp goertzel_hr.cpp pulse_morphology.cpp hr_tracker.cpp vitals_fusion.cpp fast_math.cpp
+#include "checkpoint.h"
+#include "regression_spo2.h"
+#include "goertzel_hr.h"
+#include "pulse_morphology.h"
+#include "hr_tracker.h"
+#include "vitals_fusion.h"
+#include <Preferences.h>
+#include <esp_sleep.h>
+#include "host_test.h"
+
+#define FS 100
+#define HOP 25
+#define BPM 72.0f
+#define NOISE 0.1f    // of the pulse amplitude
+#define SLEEP_SEC 30
+#define MAX_HOPS 400  // 100 s
+#define WAKES 200
+
+// The sketch's engines that a checkpoint snapshots and seeds, fed and fused
+// as the sketch does
+struct Pipeline {
+  RegressionSpO2 spo2;
+  GoertzelBank hr, spectrum;
+  HrTracker tracker;
+  PulseMorphology morphology;
+  VitalsFusion fusion;
+  const CheckpointEngines engines = {&spo2, &hr, &spectrum, &tracker, &morphology, &fusion};
+
+  void begin() {
+    spo2.begin(FS);
+    hr.begin(FS, 90, 2, 24);             // GOERTZEL_START_BPM, _STEP_BPM, _BINS
+    spectrum.begin(FS, 120, 3, 54, 2.0f);  // the tracker's full band
+    tracker.begin(54);
+    morphology.begin(FS);
+    fusion.begin();
+  }
+
+  void restore(const EstimatorCheckpoint &cp) { checkpointRestore(engines, cp, FS / HOP); }
+
+  void save(EstimatorCheckpoint *cp) {
+    checkpointCapture(engines, cp);
+    cp->sleepSeconds = SLEEP_SEC;
+    checkpointSave(cp);
+  }
+
+  // Hops until both fused vitals are valid, MAX_HOPS if never
+  uint32_t runToValid(uint32_t *n) {
+    for (uint32_t hop = 1; hop <= MAX_HOPS; hop++) {
+      for (uint8_t i = 0; i < HOP; i++, (*n)++) {
+        float phase = fmodf(*n / (float)FS * BPM / 60.0f, 1.0f);
+        float pulse = expf(-powf((phase - 0.2f) / 0.08f, 2)) + hostNoise() * NOISE;
+        uint32_t ir = (uint32_t)(100000 - 1000 * pulse);
+        spo2.addSample((uint32_t)(60000 - 300 * pulse), ir);
+        hr.addSample(ir);
+        spectrum.addSample(ir);
+        morphology.addSample(ir);
+      }
+      BeatFeatures beat;
+      while (morphology.pop(&beat));
+      tracker.addColumn(spectrum);
+      fusion.predict();
+      int32_t bpm, percent;
+      int8_t valid;
+      if (hr.estimate(&bpm, &valid)) fusion.addHeartRate(bpm, 100);
+      if (tracker.estimate(&bpm, &valid)) fusion.addHeartRate(bpm, 180);
+      if (spo2.estimate(&percent, &valid)) fusion.addSpo2(percent, 200);
+      if (fusion.heartRate(&bpm) && fusion.oxygenSaturation(&percent)) return hop;
+    }
+    return MAX_HOPS;
+  }
+};
+
+int main() {
+  hostNvsErase();
+  EstimatorCheckpoint cp;
+
+  // Power-up with nothing saved
+  hostWakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+  CHECK(!checkpointLoad(&cp));
+
+  // Each round: cold start, run on, sleep, timer wake from the checkpoint
+  uint32_t coldHops = 0, warmHops = 0;
+  for (uint16_t wake = 0; wake < WAKES; wake++) {
+    uint32_t n = hostRandom() % FS;  // random pulse phase at the start
+    Pipeline cold;
+    cold.begin();
+    uint32_t hops = cold.runToValid(&n);
+    CHECK(hops < MAX_HOPS);
+    coldHops += hops;
+    cold.runToValid(&n);  // settle before the snapshot
+    memset(&cp, 0, sizeof(cp));
+    cold.save(&cp);
+
+    hostWakeupCause = ESP_SLEEP_WAKEUP_TIMER;
+    n += SLEEP_SEC * FS;
+    CHECK(checkpointLoad(&cp));
+    CHECK(cp.flags == (CHECKPOINT_HAS_HR | CHECKPOINT_HAS_SPO2));
+    Pipeline warm;
+    warm.begin();
+    warm.restore(cp);
+    // Every engine with a baseline starts from the saved one
+    CHECK(warm.hr.dcLevel() == cp.pulseDc && warm.spectrum.dcLevel() == cp.pulseDc);
+    CHECK(warm.morphology.dcLevel() == cp.pulseDc);
+    hops = warm.runToValid(&n);
+    CHECK(hops < MAX_HOPS);
+    warmHops += hops;
+  }
+  printf("mean time to valid over %u wakes: cold %.2f hops, restored %.2f hops\n", WAKES, coldHops / (float)WAKES,
+         warmHops / (float)WAKES);
+  CHECK(warmHops < coldHops);
+
+  // The copy was consumed: another boot only finds the NVS baselines
+  CHECK(checkpointLoad(&cp));
+  CHECK(cp.flags == CHECKPOINT_FROM_NVS);
+
+  // A reset with a fresh RTC copy ignores it
+  Pipeline pipeline;
+  pipeline.begin();
+  uint32_t n = 0;
+  pipeline.runToValid(&n);
+  pipeline.save(&cp);
+  hostWakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+  CHECK(checkpointLoad(&cp));
+  CHECK(cp.flags == CHECKPOINT_FROM_NVS);
+
+  // Nothing at all after the flash is erased
+  hostNvsErase();
+  CHECK(!checkpointLoad(&cp));
+  return hostTestResult();
+}
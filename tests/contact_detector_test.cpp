@@ -0,0 +1,86 @@
+// Contact search on an emulated MAX30102 (no proximity interrupt): the
+// pilot finds the wrist, stray readings don't, and losing the wrist goes
+// back to the pilot.
+// sources: contact_detector.cpp
+#include "contact_detector.h"
+#include "host_test.h"
+
+#define AMPLITUDE 80        // the sketch's ledBrightness
+#define LOSS_LEVEL 50000    // LOW_SIGNAL_IR
+#define LOSS_SAMPLES 100    // 1 s
+#define POLL_MS 250         // idle loop delay
+
+static unsigned long wristFrom = (unsigned long)-1, wristUntil = (unsigned long)-1;
+
+static bool onWrist(unsigned long ms) { return ms >= wristFrom && ms < wristUntil; }
+
+// Polls like the idle loop until contact or the deadline; returns the time found, or 0
+static unsigned long pollUntil(ContactDetector &contact, unsigned long deadlineMs) {
+  while (millis() < deadlineMs) {
+    delay(POLL_MS);
+    if (contact.poll()) return millis();
+  }
+  return 0;
+}
+
+// Reads like the acquisition loop until contact is lost or the deadline
+static bool acquireUntil(ContactDetector &contact, MAX30105 &sensor, unsigned long deadlineMs) {
+  while (millis() < deadlineMs) {
+    delay(10);
+    sensor.check();
+    while (sensor.available()) {
+      uint32_t ir = sensor.getFIFOIR();
+      sensor.nextSample();
+      if (!contact.addSample(ir)) return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  MAX30105 sensor;
+  sensor.onWrist = onWrist;
+  sensor.setPulseAmplitudeRed(AMPLITUDE);  // as left by setup()
+  sensor.setPulseAmplitudeIR(AMPLITUDE);
+  sensor.setPulseAmplitudeGreen(AMPLITUDE);
+
+  ContactDetector contact;
+  contact.begin(&sensor, 3, AMPLITUDE, AMPLITUDE, LOSS_LEVEL, LOSS_SAMPLES);
+  CHECK(!contact.onSkin());
+  CHECK(sensor.ir == CONTACT_PILOT_CURRENT && sensor.red == 0 && sensor.green == 0);
+
+  // Off the wrist, and a touch shorter than the hit run, find nothing
+  wristFrom = 3000;
+  wristUntil = 3030;
+  CHECK(pollUntil(contact, 6000) == 0);
+  CHECK(sensor.ir == CONTACT_PILOT_CURRENT);
+
+  // On the wrist: found within two polls, LEDs back, pilot samples dropped
+  wristFrom = 6100;
+  wristUntil = 12000;
+  unsigned long found = pollUntil(contact, 9000);
+  printf("contact after %lu ms\n", found - wristFrom);
+  CHECK(found && found - wristFrom <= 2 * POLL_MS);
+  CHECK(contact.onSkin());
+  CHECK(sensor.red == AMPLITUDE && sensor.ir == AMPLITUDE && sensor.green == AMPLITUDE);
+  CHECK(!sensor.available());
+
+  // Stays on while worn, back to the pilot about a second after removal
+  CHECK(acquireUntil(contact, sensor, 11000));
+  CHECK(!acquireUntil(contact, sensor, 14000));
+  unsigned long lost = millis();
+  printf("contact lost after %lu ms\n", lost - wristUntil);
+  CHECK(lost - wristUntil >= 1000 && lost - wristUntil <= 1100);
+  CHECK(!contact.onSkin());
+  CHECK(sensor.ir == CONTACT_PILOT_CURRENT && sensor.red == 0 && sensor.green == 0);
+  CHECK(pollUntil(contact, 16000) == 0);
+
+  // Ambient slot: the third LED stays dark after contact
+  ContactDetector ambient;
+  ambient.begin(&sensor, 3, AMPLITUDE, 0, LOSS_LEVEL, LOSS_SAMPLES);
+  wristFrom = 16000;
+  wristUntil = 20000;
+  CHECK(pollUntil(ambient, 17000) != 0);
+  CHECK(sensor.ir == AMPLITUDE && sensor.green == 0);
+  return hostTestResult();
+}
@@ -0,0 +1,63 @@
+// fast_math against libm: the on-device benchmark's error sweep through the
+// real fastMathBenchmark(), and the cost of each pair timed on the host.
+// The host has divide and square root in hardware, so only the logs are
+// expected to win here; on the S3 all five are (FAST_MATH_BENCH).
+// sources: fast_math.cpp
+#include "fast_math.h"
+#include "host_test.h"
+
+#define SWEEP 4096
+#define REPEAT 64  // sweeps per timing
+#define RUNS 15    // best of
+
+static float x[SWEEP];
+static volatile float sink;
+
+template <typename F> static uint64_t sweepNanos(F f) {
+  float acc = 0;
+  uint64_t start = hostNanos();
+  for (int r = 0; r < REPEAT; r++)
+    for (int i = 0; i < SWEEP; i++) acc += f(x[i]);
+  uint64_t ns = hostNanos() - start;
+  sink = acc;
+  return ns;
+}
+
+// Best of RUNS for each, interleaved so both see the same machine
+template <typename F, typename G> static void timePair(F fast, G libm, float *fastNs, float *libmNs) {
+  uint64_t bestFast = UINT64_MAX, bestLibm = UINT64_MAX;
+  for (int run = 0; run < RUNS; run++) {
+    uint64_t ns = sweepNanos(fast);
+    if (ns < bestFast) bestFast = ns;
+    ns = sweepNanos(libm);
+    if (ns < bestLibm) bestLibm = ns;
+  }
+  *fastNs = (float)bestFast / (REPEAT * SWEEP);
+  *libmNs = (float)bestLibm / (REPEAT * SWEEP);
+}
+
+int main() {
+  FastMathBench bench[FAST_MATH_BENCH_COUNT];
+  fastMathBenchmark(bench);
+
+  // Same log-spaced range as the device sweep
+  for (int i = 0; i < SWEEP; i++) x[i] = 1e-6f * powf(1e18f, (float)i / (SWEEP - 1));
+
+  // Bounds from fast_math.h, with the rounding it allows for
+  static const float bound[FAST_MATH_BENCH_COUNT] = {6.2e-5f, 2.4e-5f, 2.4e-5f, 5e-5f, 3.5e-5f};
+  float fast[FAST_MATH_BENCH_COUNT], libm[FAST_MATH_BENCH_COUNT];
+  timePair([](float v) { return fastRecip(v); }, [](float v) { return 1.0f / v; }, &fast[0], &libm[0]);
+  timePair([](float v) { return fastRsqrt(v); }, [](float v) { return 1.0f / sqrtf(v); }, &fast[1], &libm[1]);
+  timePair([](float v) { return fastSqrt(v); }, [](float v) { return sqrtf(v); }, &fast[2], &libm[2]);
+  timePair([](float v) { return fastLog2(v); }, [](float v) { return log2f(v); }, &fast[3], &libm[3]);
+  timePair([](float v) { return fastLog(v); }, [](float v) { return logf(v); }, &fast[4], &libm[4]);
+  for (uint8_t i = 0; i < FAST_MATH_BENCH_COUNT; i++) {
+    printf("%-5s fast %.2f ns, libm %.2f ns (%.2fx), max error %.2g of %.2g\n", bench[i].name, fast[i], libm[i],
+           libm[i] / fast[i], bench[i].maxError, bound[i]);
+    CHECK(bench[i].maxError > 0 && bench[i].maxError <= bound[i]);
+  }
+  // A table lookup and an interpolation against libm's polynomial
+  CHECK(fast[3] < libm[3]);
+  CHECK(fast[4] < libm[4]);
+  return hostTestResult();
+}
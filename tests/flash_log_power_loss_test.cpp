@@ -0,0 +1,93 @@
+// Power cut at a random point of an append or a sector erase, thousands of
+// times over: after every reboot the log must resume right after the last
+// acknowledged record (or one past it, if the cut record was complete) and
+// keep accepting appends.
+// sources: flash_log.cpp checkpoint.cpp regression_spo2.cpp goertzel_hr.cpp pulse_morphology.cpp hr_tracker.cpp vitals_fusion.cpp fast_math.cpp
+#include "flash_log.h"
+#include "host_test.h"
+
+#define SECTORS 64
+#define CUTS 3000
+#define MAX_BUDGET 3000  // bytes programmed before the cut
+#define ERASE_COST 64    // an erase counts as this many bytes of budget
+
+// NOR flash: erase sets bytes to 0xFF, programming can only clear bits
+static uint8_t flash[SECTORS * FLASH_LOG_SECTOR_BYTES];
+static const esp_partition_t partition = {0, sizeof(flash), "flashlog"};
+static int32_t budget = -1;  // bytes left before the cut, -1 for none
+static uint32_t readBytes;
+
+struct PowerLoss {};
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t, esp_partition_subtype_t, const char *) {
+  return &partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *, size_t offset, void *dst, size_t size) {
+  memcpy(dst, flash + offset, size);
+  readBytes += size;
+  return ESP_OK;
+}
+
+// The byte being programmed at the cut keeps a random subset of its bits
+esp_err_t esp_partition_write(const esp_partition_t *, size_t offset, const void *src, size_t size) {
+  const uint8_t *bytes = (const uint8_t *)src;
+  for (size_t i = 0; i < size; i++) {
+    if (budget == 0) {
+      flash[offset + i] &= bytes[i] | (uint8_t)hostRandom();
+      throw PowerLoss();
+    }
+    if (budget > 0) budget--;
+    flash[offset + i] &= bytes[i];
+  }
+  return ESP_OK;
+}
+
+// A cut erase leaves the sector partly erased
+esp_err_t esp_partition_erase_range(const esp_partition_t *, size_t offset, size_t size) {
+  if (budget >= 0 && budget < ERASE_COST) {
+    for (size_t i = 0; i < size; i++)
+      if (hostRandom() & 1) flash[offset + i] = 0xFF;
+    budget = 0;
+    throw PowerLoss();
+  }
+  if (budget > 0) budget -= ERASE_COST;
+  memset(flash + offset, 0xFF, size);
+  return ESP_OK;
+}
+
+int main() {
+  memset(flash, 0xFF, sizeof(flash));
+  uint32_t acked = 0, maxReadBytes = 0;
+  bool appendFailed = false;
+  for (uint32_t cut = 0; cut < CUTS && !appendFailed; cut++) {
+    FlashLog log;
+    budget = -1;
+    readBytes = 0;
+    CHECK(log.begin("flashlog"));
+    if (readBytes > maxReadBytes) maxReadBytes = readBytes;
+    uint32_t seq = log.nextSeq();
+    if (seq != acked && seq != acked + 1) printf("cut %u: resumed at %u, acked %u\n", cut, seq, acked);
+    CHECK(seq == acked || seq == acked + 1);
+    acked = seq;
+
+    budget = hostRandom() % MAX_BUDGET;
+    try {
+      for (;;) {
+        // Differs per boot, so a record re-written over torn bytes can't match them
+        FlashTrackRecord record = {acked * 250, (float)cut, 'H', 1};
+        if (!log.append(FLASH_RECORD_TRACK_POINT, &record, sizeof(record))) {
+          appendFailed = true;
+          break;
+        }
+        acked++;
+      }
+    } catch (PowerLoss &) {
+    }
+  }
+  printf("%u records over %u cuts, recovery read at most %u bytes\n", acked, CUTS, maxReadBytes);
+  CHECK(!appendFailed);
+  CHECK(acked > 2 * sizeof(flash) / sizeof(FlashTrackRecord));  // each record takes over twice that: wrapped
+  CHECK(maxReadBytes <= SECTORS * 16 + FLASH_LOG_SECTOR_BYTES);  // 16-byte headers plus one sector
+  return hostTestResult();
+}
@@ -0,0 +1,93 @@
+// Goertzel bank as configured in the sketch: HR accuracy on synthetic
+// traces across the band (off the bin grid, drifting, noisy), and cost per
+// sample against a DFT of the same bins over the resonators' 4 s memory
+// every hop. Like the sketch, an invalid estimate recenters the band on a
+// coarse outside estimate; the Maxim routine that provides it on the device
+// is not part of the tree, so a rounded true rate stands in for it.
+// sources: goertzel_hr.cpp
+#include "goertzel_hr.h"
+#include "host_test.h"
+
+#define FS 100
+#define HOP 25
+#define BINS 24         // GOERTZEL_BINS
+#define STEP_BPM 2      // GOERTZEL_STEP_BPM
+#define START_BPM 90    // GOERTZEL_START_BPM
+#define SECONDS 40
+#define SETTLE_SEC 10   // not scored
+#define AMPLITUDE 1000  // counts
+#define NOISE 500       // counts, uniform
+#define DRIFT_BPM 3     // slow sinusoidal HR variation, 20 s period
+#define DFT_WINDOW 400  // 4 s, the bank's tauSec
+
+static float trace[SECONDS * FS];
+
+static void makeTrace(float bpm) {
+  HostPulse pulse;
+  for (uint32_t n = 0; n < SECONDS * FS; n++)
+    trace[n] = 100000 - AMPLITUDE * pulse.next(bpm + DRIFT_BPM * sinf(2 * PI * n / (20.0f * FS)), FS) +
+               NOISE * hostNoise();
+}
+
+// Same bins as a plain DFT over the last DFT_WINDOW samples, once per hop
+static float dftHop(uint32_t end, float firstBpm) {
+  float best = 0, bestBpm = 0;
+  for (uint8_t i = 0; i < BINS; i++) {
+    float w = 2 * PI * (firstBpm + i * STEP_BPM) / 60.0f / FS, re = 0, im = 0;
+    for (uint32_t k = end - DFT_WINDOW; k < end; k++) {
+      re += trace[k] * cosf(w * k);
+      im -= trace[k] * sinf(w * k);
+    }
+    if (re * re + im * im > best) {
+      best = re * re + im * im;
+      bestBpm = firstBpm + i * STEP_BPM;
+    }
+  }
+  return bestBpm;
+}
+
+int main() {
+  static const float rates[] = {47, 61, 73, 97, 123, 151, 177};
+  uint64_t bankNanos = 0, dftNanos = 0;
+  uint32_t bankSamples = 0, dftHops = 0;
+  volatile float sink = 0;
+  for (float bpm : rates) {
+    makeTrace(bpm);
+    GoertzelBank bank;
+    bank.begin(FS, START_BPM, STEP_BPM, BINS);
+    float seed = roundf(bpm / 10) * 10;  // stands in for the Maxim estimate the sketch recenters on
+    uint32_t scored = 0, valid = 0;
+    float errorSum = 0;
+    for (uint32_t n = 0; n < SECONDS * FS; n += HOP) {
+      uint64_t t0 = hostNanos();
+      for (uint32_t i = n; i < n + HOP; i++) bank.addSample((uint32_t)trace[i]);
+      int32_t hr;
+      int8_t ok;
+      bank.estimate(&hr, &ok);
+      if (!ok) bank.recenter(seed);
+      bankNanos += hostNanos() - t0;
+      bankSamples += HOP;
+      if (n < SETTLE_SEC * FS) continue;
+      scored++;
+      if (ok) {
+        valid++;
+        errorSum += fabsf(hr - (bpm + DRIFT_BPM * sinf(2 * PI * n / (20.0f * FS))));
+      }
+      if (n + HOP >= DFT_WINDOW) {
+        t0 = hostNanos();
+        sink = sink + dftHop(n + HOP, bpm - BINS / 2 * STEP_BPM);
+        dftNanos += hostNanos() - t0;
+        dftHops++;
+      }
+    }
+    float meanError = valid ? errorSum / valid : 0;
+    printf("%3.0f bpm: valid %3.0f%% of hops, mean error %.1f bpm\n", bpm, 100.0f * valid / scored, meanError);
+    CHECK(valid >= scored * 9 / 10);
+    CHECK(meanError <= 3.0f);  // the 4 s resonators lag the drift by ~2 bpm
+  }
+  float bankPerSample = bankNanos / (float)bankSamples;
+  float dftPerSample = dftNanos / (float)(dftHops * HOP);
+  printf("cost per sample: bank %.0f ns, per-hop DFT over the same bins %.0f ns\n", bankPerSample, dftPerSample);
+  CHECK(bankPerSample < dftPerSample);
+  return hostTestResult();
+}
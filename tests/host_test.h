@@ -0,0 +1,60 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+// Minimal checks for the host tests: CHECK counts failures, main() returns
+// hostTestResult() so run_host_tests.sh sees the exit status.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+static int hostTestFailures;
+
+#define CHECK(cond)                                                       \
+  do {                                                                    \
+    if (!(cond)) {                                                        \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);     \
+      hostTestFailures++;                                                 \
+    }                                                                     \
+  } while (0)
+
+// Deterministic noise, the same on every host (xorshift32)
+static uint32_t hostRandomState = 2463534242u;
+
+static inline uint32_t hostRandom() {
+  hostRandomState ^= hostRandomState << 13;
+  hostRandomState ^= hostRandomState >> 17;
+  hostRandomState ^= hostRandomState << 5;
+  return hostRandomState;
+}
+
+// Uniform in [-1, 1)
+static inline float hostNoise() { return (float)(hostRandom() % 2000) / 1000.0f - 1.0f; }
+
+// Wall-clock nanoseconds for the cost benchmarks; micros() is the
+// emulated clock and only moves when a test advances it
+static inline uint64_t hostNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Synthetic pulse, 0..~1: systolic peak plus a dicrotic wave. The phase is
+// accumulated so the rate can change mid-trace.
+struct HostPulse {
+  float phase = 0;
+
+  float next(float bpm, float sampleRate) {
+    phase += bpm / 60.0f / sampleRate;
+    if (phase >= 1) phase -= 1;
+    return expf(-powf((phase - 0.2f) / 0.08f, 2)) + 0.4f * expf(-powf((phase - 0.5f) / 0.08f, 2));
+  }
+};
+
+static inline int hostTestResult() {
+  printf(hostTestFailures ? "FAILED (%d)\n" : "ok\n", hostTestFailures);
+  return hostTestFailures ? 1 : 0;
+}
+
+#endif
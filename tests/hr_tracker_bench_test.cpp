@@ -0,0 +1,72 @@
+// Viterbi tracker over the sketch's full-band spectrogram: fewer wrong or
+// missing values than picking each hop's spectral peak through motion
+// bursts, per-hop cost that stays flat over a long run, and memory.
+// sources: hr_tracker.cpp goertzel_hr.cpp fast_math.cpp
+#include "hr_tracker.h"
+#include "host_test.h"
+
+#define FS 100
+#define HOP 25
+#define BINS 54        // TRACK_BINS
+#define STEP_BPM 3     // TRACK_STEP_BPM
+#define TAU_SEC 2.0f   // TRACK_TAU_SEC
+#define BPM 72.0f
+#define SECONDS 300
+#define AMPLITUDE 1000  // counts
+#define NOISE 300       // counts, uniform
+#define BURST_EVERY 8   // s, motion burst period
+#define BURST_SEC 2     // burst length
+#define BURST_BPM 140   // artifact rate during a burst
+#define BURST_GAIN 2.0f // artifact amplitude, relative to the pulse
+#define TOLERANCE 6     // bpm, more off counts as wrong
+
+int main() {
+  GoertzelBank bank;
+  HrTracker tracker;
+  bank.begin(FS, (GOERTZEL_MIN_BPM + GOERTZEL_MAX_BPM) / 2, STEP_BPM, BINS, TAU_SEC);
+  tracker.begin(BINS);
+
+  HostPulse pulse, motion;
+  const uint32_t hops = SECONDS * FS / HOP, quarter = hops / 4;
+  uint32_t rawWrong = 0, trackedWrong = 0, scored = 0;
+  uint64_t firstQuarter = 0, lastQuarter = 0, worst = 0;
+  for (uint32_t hop = 0; hop < hops; hop++) {
+    for (uint32_t i = 0; i < HOP; i++) {
+      uint32_t n = hop * HOP + i;
+      float x = AMPLITUDE * pulse.next(BPM, FS) + NOISE * hostNoise();
+      if (n % (BURST_EVERY * FS) < BURST_SEC * FS) x += BURST_GAIN * AMPLITUDE * motion.next(BURST_BPM, FS);
+      bank.addSample((uint32_t)(100000 - x));
+    }
+
+    // Raw: this hop's strongest bin
+    uint8_t peak = 0;
+    for (uint8_t i = 1; i < BINS; i++)
+      if (bank.binPower(i) > bank.binPower(peak)) peak = i;
+    float raw = bank.binBpm(peak);
+
+    uint64_t t0 = hostNanos();
+    tracker.addColumn(bank);
+    int32_t hr;
+    int8_t valid;
+    tracker.estimate(&hr, &valid);
+    uint64_t spent = hostNanos() - t0;
+    if (hop < quarter) firstQuarter += spent;
+    if (hop >= hops - quarter) lastQuarter += spent;
+    if (hop > 0 && spent > worst) worst = spent;
+
+    if (hop * HOP < 10 * FS) continue;  // spectrogram and lag filling
+    scored++;
+    if (fabsf(raw - BPM) > TOLERANCE) rawWrong++;
+    if (!valid || abs(hr - (int32_t)BPM) > TOLERANCE) trackedWrong++;
+  }
+  printf("wrong or missing: raw peak %.1f%%, tracked %.1f%% of %u hops\n", 100.0f * rawWrong / scored,
+         100.0f * trackedWrong / scored, scored);
+  printf("per hop: %.0f ns first quarter, %.0f ns last quarter, %llu ns worst; %u bytes\n",
+         firstQuarter / (float)quarter, lastQuarter / (float)quarter, (unsigned long long)worst,
+         (unsigned)sizeof(HrTracker));
+  CHECK(rawWrong > 0);  // the bursts do pull the raw peak away
+  CHECK(trackedWrong * 3 < rawWrong * 2);
+  CHECK(lastQuarter < 2 * firstQuarter);  // bounded: no growth with run length
+  CHECK(sizeof(HrTracker) <= 2048);
+  return hostTestResult();
+}
@@ -0,0 +1,91 @@
+// Cost of the 2 s + 10 s estimates over shared intermediates against the
+// single-window pipeline, and against two independent pipelines.
+// sources: multi_window.cpp regression_spo2.cpp pulse_morphology.cpp fast_math.cpp
+#include "multi_window.h"
+#include "host_test.h"
+
+#define FS 100
+#define HOP 25
+#define SECONDS 60
+#define SAMPLES (SECONDS * FS)
+#define RUNS 5  // best of, against scheduler noise
+
+static uint32_t irTrace[SAMPLES], redTrace[SAMPLES];
+
+// Filters, beats and window sums once, then one estimate per window per hop
+struct SharedPipeline {
+  RegressionSpO2 filtered;
+  PulseMorphology morphology;
+  MultiWindowEstimator windows;
+
+  void begin() {
+    filtered.begin(FS);
+    morphology.begin(FS);
+    windows.begin(FS);
+  }
+
+  uint32_t run(const float *seconds, uint8_t count) {
+    uint32_t valid = 0;
+    for (uint32_t n = 0; n < SAMPLES; n++) {
+      filtered.addSample(redTrace[n], irTrace[n]);
+      morphology.addSample(irTrace[n]);
+      windows.addSample(filtered);
+      if (n % HOP != HOP - 1) continue;
+      BeatFeatures beat;
+      while (morphology.pop(&beat)) windows.addBeat(beat);
+      for (uint8_t w = 0; w < count; w++) {
+        WindowEstimate estimate;
+        windows.estimate(seconds[w], &estimate);
+        valid += estimate.validHeartRate;
+      }
+    }
+    return valid;
+  }
+};
+
+template <typename F> static uint64_t bestNanos(F body) {
+  uint64_t best = UINT64_MAX;
+  for (int run = 0; run < RUNS; run++) {
+    uint64_t start = hostNanos();
+    body();
+    uint64_t ns = hostNanos() - start;
+    if (ns < best) best = ns;
+  }
+  return best;
+}
+
+int main() {
+  HostPulse pulse;
+  for (uint32_t n = 0; n < SAMPLES; n++) {
+    float ac = pulse.next(72, FS);
+    irTrace[n] = (uint32_t)(100000 * (1 - 0.02f * ac) + 20 * hostNoise());
+    redTrace[n] = (uint32_t)(60000 * (1 - 0.012f * ac) + 20 * hostNoise());
+  }
+
+  static const float both[] = {2, 10}, longOnly[] = {10}, shortOnly[] = {2};
+  static SharedPipeline a, b;
+  uint32_t valid = 0;
+  uint64_t single = bestNanos([&] {
+    a.begin();
+    valid = a.run(longOnly, 1);
+  });
+  uint64_t shared = bestNanos([&] {
+    a.begin();
+    valid = a.run(both, 2);
+  });
+  uint64_t separate = bestNanos([&] {
+    a.begin();
+    b.begin();
+    valid = a.run(shortOnly, 1) + b.run(longOnly, 1);
+  });
+
+  uint32_t hops = SAMPLES / HOP;
+  printf("per hop: single window %.2f us, 2 s + 10 s shared %.2f us (%.2fx), two pipelines %.2f us (%.2fx)\n",
+         single / 1e3 / hops, shared / 1e3 / hops, (double)shared / single, separate / 1e3 / hops,
+         (double)separate / single);
+  CHECK(valid > 0);
+  // The second window only adds its block sum and beat scan
+  CHECK(shared * 2 < single * 3);
+  CHECK(shared < separate);
+  return hostTestResult();
+}
@@ -0,0 +1,114 @@
+// Window HR on a barely perfused trace: noise the beat detector fires on
+// must not come out as a valid rate, while a clean trace still does, and
+// the short window follows a rate step before the long one.
+// sources: multi_window.cpp regression_spo2.cpp pulse_morphology.cpp fast_math.cpp
+#include "multi_window.h"
+#include "host_test.h"
+
+#define FS 100
+#define HOP 25
+#define SETTLE_SAMPLES 2000
+#define TOTAL_SAMPLES 12000
+#define IR_DC 100000.0f
+#define RED_DC 60000.0f
+#define NOISE_SEEDS 8
+#define STEP_SAMPLES 6000     // 72 -> 110 bpm here
+#define STEP_FROM 72.0f
+#define STEP_TO 110.0f
+#define SETTLE_HOPS 8         // 2 s of consecutive right readings
+
+struct Outcome {
+  uint32_t hops, valid, wrong;  // wrong: valid but further off than the tolerance
+  uint32_t firstValid;          // sample index of the first valid hop
+  uint32_t settled;             // samples from the step to the first SETTLE_HOPS right hops in a row
+};
+
+// The short window averages one or two intervals, so it jitters more
+struct Window {
+  float seconds, toleranceBpm;
+};
+
+// Runs the shared filters and beats into the window like the sketch does;
+// stepBpm, when set, takes over from bpm at STEP_SAMPLES
+static void run(float bpm, float perfusion, float noise, const Window &window, Outcome *out, float stepBpm = 0) {
+  RegressionSpO2 filtered;
+  PulseMorphology morphology;
+  MultiWindowEstimator windows;
+  HostPulse pulse;
+  filtered.begin(FS);
+  morphology.begin(FS);
+  windows.begin(FS);
+  *out = {0, 0, 0, 0, UINT32_MAX};
+  uint32_t runStart = 0, runHops = 0;  // current run of right hops
+  for (uint32_t n = 0; n < TOTAL_SAMPLES; n++) {
+    if (stepBpm && n == STEP_SAMPLES) bpm = stepBpm;
+    float ac = pulse.next(bpm, FS);
+    uint32_t ir = (uint32_t)(IR_DC * (1 - perfusion * ac) + noise * hostNoise());
+    uint32_t red = (uint32_t)(RED_DC * (1 - 0.6f * perfusion * ac) + noise * hostNoise());
+    filtered.addSample(red, ir);
+    morphology.addSample(ir);
+    windows.addSample(filtered);
+    if (n % HOP != HOP - 1) continue;
+
+    BeatFeatures beat;
+    while (morphology.pop(&beat)) windows.addBeat(beat);
+    WindowEstimate estimate;
+    windows.estimate(window.seconds, &estimate);
+    bool ok = estimate.validHeartRate && fabsf(estimate.heartRate - bpm) <= window.toleranceBpm;
+    if (estimate.validHeartRate && !out->firstValid) out->firstValid = n + 1;
+    if (!ok) runHops = 0;
+    else if (runHops++ == 0) runStart = n + 1;
+    if (stepBpm && runHops == SETTLE_HOPS && runStart > STEP_SAMPLES && out->settled == UINT32_MAX)
+      out->settled = runStart - STEP_SAMPLES;
+    if (n < SETTLE_SAMPLES || (stepBpm && n >= STEP_SAMPLES)) continue;
+    out->hops++;
+    if (!estimate.validHeartRate) continue;
+    out->valid++;
+    if (!ok) out->wrong++;
+  }
+}
+
+int main() {
+  static const Window windows[] = {{2, 10}, {10, 3}};
+  static const float noises[] = {5, 20, 50, 200, 400};
+  Outcome outcome;
+  for (const Window &window : windows) {
+    // 50 bpm at 0.1% perfusion: the detector mostly sees noise, which must
+    // never come out as a rate, whatever the noise sequence
+    for (float noise : noises) {
+      uint32_t valid = 0, hops = 0;
+      for (uint32_t seed = 0; seed < NOISE_SEEDS; seed++) {
+        hostRandomState = 2463534242u + seed * 7919;
+        run(50, 0.001f, noise, window, &outcome);
+        valid += outcome.valid;
+        hops += outcome.hops;
+      }
+      printf("%2.0f s window, 0.1%% perfusion, noise %3.0f: %u of %u hops valid\n", window.seconds, noise, valid, hops);
+      CHECK(valid == 0);
+    }
+
+    // Well perfused: the gate must not cost the normal case
+    run(72, 0.02f, 20, window, &outcome);
+    printf("%2.0f s window, 2%% perfusion: %u of %u hops valid, %u wrong\n", window.seconds, outcome.valid, outcome.hops,
+           outcome.wrong);
+    CHECK(outcome.wrong == 0);
+    CHECK(outcome.valid >= outcome.hops * 9 / 10);
+  }
+
+  // First reading, and a 72 -> 110 bpm step: each window follows within
+  // its own span, so the display window settles well before the log one
+  Outcome fast, slow;
+  run(STEP_FROM, 0.02f, 20, windows[0], &fast, STEP_TO);
+  run(STEP_FROM, 0.02f, 20, windows[1], &slow, STEP_TO);
+  printf("first valid: 2 s window %.2f s, 10 s window %.2f s\n", fast.firstValid / (float)FS,
+         slow.firstValid / (float)FS);
+  printf("%.0f -> %.0f bpm step settled: 2 s window %.2f s, 10 s window %.2f s\n", STEP_FROM, STEP_TO,
+         fast.settled / (float)FS, slow.settled / (float)FS);
+  CHECK(fast.wrong == 0 && slow.wrong == 0);
+  CHECK(fast.firstValid < slow.firstValid);
+  CHECK(slow.firstValid >= windows[1].seconds * FS);
+  CHECK(fast.settled < slow.settled);
+  CHECK(fast.settled <= 5 * FS);
+  CHECK(slow.settled <= 12 * FS);
+  return hostTestResult();
+}
@@ -0,0 +1,127 @@
+// NN layer shapes, the int8 conv/pool/dense kernels against a float
+// reference on random weights, and the cost of one forward pass.
+// sources: nn_hr.cpp
+#include "nn_hr.h"
+#include "host_test.h"
+
+#define IN_LEN 64
+#define TRIALS 20
+
+static int8_t randomS8() { return (int8_t)(hostRandom() >> 24); }
+
+// Output length of a valid conv over inLen time steps
+static uint16_t convLen(uint16_t inLen, const NnConvLayer &layer) { return (inLen - layer.kernel) / layer.stride + 1; }
+
+static void checkShapes() {
+  CHECK(nnConv1.inCh == NN_IN_CH);
+  CHECK(nnConv2.inCh == nnConv1.outCh);
+  CHECK(nnConv3.inCh == nnConv2.outCh);
+  CHECK(nnConv3.outCh == NN_FEATURES);
+  CHECK(convLen(NN_WINDOW, nnConv1) == NN_CONV1_LEN);
+  CHECK(convLen(NN_CONV1_LEN, nnConv2) == NN_CONV2_LEN);
+  CHECK(convLen(NN_CONV2_LEN, nnConv3) == NN_CONV3_LEN);
+  CHECK(NN_CONV1_LEN == 127 && NN_CONV2_LEN == 60 && NN_CONV3_LEN == 27);
+  // Every receptive field and dense row must be whole 16-byte blocks for the PIE path
+  static const NnConvLayer *layers[] = {&nnConv1, &nnConv2, &nnConv3};
+  for (const NnConvLayer *layer : layers) {
+    CHECK(layer->kernel * layer->inCh % 16 == 0);
+    CHECK(layer->stride * layer->inCh % 16 == 0);
+  }
+  CHECK(NN_FEATURES % 16 == 0);
+}
+
+// Random weights, a realistic requantization scale, and ReLU: the int8
+// result must match round(clamp(acc * scale)) to within one count
+static void checkConv() {
+  alignas(16) static int8_t weights[8 * 8 * 4];
+  static int32_t bias[8];
+  alignas(16) static int8_t in[IN_LEN * 4];
+  alignas(16) static int8_t out[IN_LEN * 8];
+  const NnConvLayer layer = {weights, bias, 4, 8, 8, 4, 1503238554, 39};  // scale 0.7 / 256
+  const double scale = (double)layer.multiplier / (double)((int64_t)1 << layer.shift);
+  uint16_t outLen = convLen(IN_LEN, layer);
+
+  int worst = 0, clipped = 0, zeroed = 0;
+  for (int trial = 0; trial < TRIALS; trial++) {
+    for (int8_t &w : weights) w = randomS8();
+    for (int32_t &b : bias) b = (int32_t)(hostNoise() * 5000);
+    for (int8_t &x : in) x = randomS8();
+    nnConv1d(in, layer, out, outLen);
+
+    for (uint16_t p = 0; p < outLen; p++)
+      for (uint8_t oc = 0; oc < layer.outCh; oc++) {
+        double acc = bias[oc];
+        for (uint8_t k = 0; k < layer.kernel; k++)
+          for (uint8_t ic = 0; ic < layer.inCh; ic++)
+            acc += (double)in[(p * layer.stride + k) * layer.inCh + ic] *
+                   weights[(oc * layer.kernel + k) * layer.inCh + ic];
+        double expected = fmin(fmax(acc * scale, 0.0), 127.0);
+        int error = abs((int)out[p * layer.outCh + oc] - (int)lround(expected));
+        if (error > worst) worst = error;
+        clipped += expected >= 127.0;
+        zeroed += expected <= 0.0;
+      }
+  }
+  int total = TRIALS * outLen * layer.outCh;
+  printf("conv: worst error %d count, %d of %d clipped, %d zeroed\n", worst, clipped, total, zeroed);
+  CHECK(worst <= 1);
+  // The scale must exercise the linear range, not just the rails
+  CHECK(clipped + zeroed < total * 3 / 4);
+}
+
+static void checkPoolAndDense() {
+  alignas(16) static int8_t act[NN_CONV3_LEN * NN_FEATURES];
+  alignas(16) static int8_t pooled[NN_FEATURES];
+  alignas(16) static int8_t weights[NN_CLASSES * NN_FEATURES];
+  static int32_t bias[NN_CLASSES];
+  int32_t logits[NN_CLASSES];
+
+  for (int trial = 0; trial < TRIALS; trial++) {
+    for (int8_t &a : act) a = (int8_t)(hostRandom() % 128);  // post-ReLU range
+    for (int8_t &w : weights) w = randomS8();
+    for (int32_t &b : bias) b = (int32_t)(hostNoise() * 10000);
+
+    nnAveragePool(act, NN_CONV3_LEN, NN_FEATURES, pooled);
+    for (uint8_t ch = 0; ch < NN_FEATURES; ch++) {
+      double sum = 0;
+      for (uint16_t p = 0; p < NN_CONV3_LEN; p++) sum += act[p * NN_FEATURES + ch];
+      CHECK(pooled[ch] == (int8_t)floor(sum / NN_CONV3_LEN));
+    }
+
+    // Integer accumulation is exact, so the logits match the float sum exactly
+    nnDense(pooled, NN_FEATURES, weights, bias, NN_CLASSES, logits);
+    for (uint8_t c = 0; c < NN_CLASSES; c++) {
+      double expected = bias[c];
+      for (uint8_t i = 0; i < NN_FEATURES; i++) expected += (double)pooled[i] * weights[c * NN_FEATURES + i];
+      CHECK(logits[c] == (int32_t)expected);
+    }
+  }
+}
+
+// One forward pass with the compiled-in (placeholder) weights: same MACs as trained ones
+static void benchInference() {
+  const uint32_t macs = NN_CONV1_LEN * nnConv1.outCh * nnConv1.kernel * nnConv1.inCh +
+                        NN_CONV2_LEN * nnConv2.outCh * nnConv2.kernel * nnConv2.inCh +
+                        NN_CONV3_LEN * nnConv3.outCh * nnConv3.kernel * nnConv3.inCh + NN_CLASSES * NN_FEATURES;
+  nnBenchmark();  // warm the caches
+  uint64_t best = UINT64_MAX;
+  for (int run = 0; run < 5; run++) {
+    uint64_t start = hostNanos();
+    nnBenchmark();
+    uint64_t ns = hostNanos() - start;
+    if (ns < best) best = ns;
+  }
+  printf("inference: %u MACs, %.1f us on the host (%.2f ns/MAC, portable kernel), %u bytes\n", macs, best / 1e3,
+         (double)best / macs, (unsigned)NnHR::memoryBytes());
+  CHECK(macs == 149776);
+  CHECK(best > 0);
+}
+
+int main() {
+  checkShapes();
+  CHECK(nnSelfTest());
+  checkConv();
+  checkPoolAndDense();
+  benchInference();
+  return hostTestResult();
+}
@@ -0,0 +1,288 @@
+// The loop must not touch the heap (memory_plan.h). Every allocator entry
+// point is interposed and counted: malloc, calloc, realloc and operator new.
+// The sketch's modules are set up as setup() does, the count is sealed, and
+// the per-hop pipeline then runs for an hour of wear with contact losses,
+// a raw capture export, logging and flash-log appends. Not covered: the
+// Maxim routine (a library outside the sketch) and the display driver.
+// sources: goertzel_hr.cpp hr_tracker.cpp autocorr_hr.cpp regression_spo2.cpp nn_hr.cpp pulse_morphology.cpp template_beat_detector.cpp event_capture.cpp multi_window.cpp vitals_fusion.cpp telemetry.cpp swinging_door.cpp flash_log.cpp checkpoint.cpp contact_detector.cpp debug_log.cpp fast_math.cpp sample_ring.cpp batch_pool.cpp
+#include "sample_ring.h"
+#include "goertzel_hr.h"
+#include "hr_tracker.h"
+#include "autocorr_hr.h"
+#include "regression_spo2.h"
+#include "nn_hr.h"
+#include "pulse_morphology.h"
+#include "template_beat_detector.h"
+#include "event_capture.h"
+#include "multi_window.h"
+#include "vitals_fusion.h"
+#include "telemetry.h"
+#include "swinging_door.h"
+#include "flash_log.h"
+#include "contact_detector.h"
+#include "debug_log.h"
+#include "MAX30105.h"
+#include "host_test.h"
+#include <new>
+
+#define FS 100
+#define HOP 25
+#define HOPS (3600 * FS / HOP)    // an hour
+#define OFF_WRIST_EVERY 180000    // ms: the band slips off every 3 min...
+#define OFF_WRIST_MS 4000         // ...for 4 s
+#define CAPTURE_AT_HOP (HOPS / 2)
+#define FLASH_SECTORS 16
+
+// Allocator interposition: the executable's definitions win over libc's,
+// so every caller in the process lands here
+static bool sealed;
+static uint32_t allocs;
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+  if (sealed) allocs++;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  if (sealed) allocs++;
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  if (sealed && size) allocs++;  // realloc(p, 0) frees
+  return __libc_realloc(ptr, size);
+}
+}
+
+void *operator new(size_t size) {
+  if (sealed) allocs++;
+  void *p = __libc_malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { __libc_free(p); }
+void operator delete[](void *p) noexcept { __libc_free(p); }
+void operator delete(void *p, size_t) noexcept { __libc_free(p); }
+void operator delete[](void *p, size_t) noexcept { __libc_free(p); }
+
+// Flash for the log, erased
+static uint8_t flash[FLASH_SECTORS * FLASH_LOG_SECTOR_BYTES];
+static const esp_partition_t partition = {0, sizeof(flash), "flashlog"};
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t, esp_partition_subtype_t, const char *) {
+  return &partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *, size_t offset, void *dst, size_t size) {
+  memcpy(dst, flash + offset, size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *, size_t offset, const void *src, size_t size) {
+  for (size_t i = 0; i < size; i++) flash[offset + i] &= ((const uint8_t *)src)[i];
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *, size_t offset, size_t size) {
+  memset(flash + offset, 0xFF, size);
+  return ESP_OK;
+}
+
+// Serial stand-in: counts what would go out
+struct Sink : Print {
+  uint32_t bytes = 0;
+  size_t write(uint8_t) override {
+    bytes++;
+    return 1;
+  }
+};
+
+static bool onWrist(unsigned long ms) { return ms % OFF_WRIST_EVERY >= OFF_WRIST_MS; }
+
+static float pulseAt(float t) {
+  float phase = fmodf(t * 72 / 60.0f, 1.0f);
+  return 0.02f * (expf(-powf((phase - 0.2f) / 0.08f, 2)) + 0.4f * expf(-powf((phase - 0.5f) / 0.08f, 2)));
+}
+
+// The sketch's globals, set up as setup() does
+static MAX30105 sensor;
+static ContactDetector contact;
+static BatchPool pool;
+static SampleRing ring;
+static GoertzelBank hrBank, spectrumBank;
+static HrTracker tracker;
+static AutocorrHR autocorr;
+static RegressionSpO2 regression;
+static NnHR nn;
+static PulseMorphology morphology;
+static TemplateBeatDetector templateDetector;
+static EventCapture capture;
+static MultiWindowEstimator windows;
+static VitalsFusion fusion;
+static VitalsTelemetry telemetry;
+static SwingingDoor hrTrack, spo2Track;
+static FlashLog flashLog;
+static Sink serial;
+static uint32_t lastIr;
+
+static void setupPipeline() {
+  logBegin(serial);
+  sensor.onWrist = onWrist;
+  sensor.pulseAt = pulseAt;
+  sensor.setPulseAmplitudeRed(80);
+  sensor.setPulseAmplitudeIR(80);
+  sensor.setPulseAmplitudeGreen(80);
+  contact.begin(&sensor, 3, 80, 80, 50000, FS);  // ledBrightness, LOW_SIGNAL_IR, CONTACT_LOSS_SAMPLES
+  pool.begin();
+  ring.begin(&pool);
+  hrBank.begin(FS, 90, 2, 24);
+  spectrumBank.begin(FS, 120, 3, 54, 2.0f);
+  tracker.begin(54);
+  autocorr.begin(&ring, FS);
+  regression.begin(FS);
+  nn.begin(&ring);
+  morphology.begin(FS);
+  templateDetector.begin(&morphology, FS);
+  CaptureConfig captureConfig;
+  captureConfig.triggers = CAPTURE_TRIGGER_SPO2_DROP | CAPTURE_TRIGGER_HR_INVALID | CAPTURE_TRIGGER_LOW_SIGNAL;
+  captureConfig.preSeconds = 5;
+  captureConfig.postSeconds = 5;
+  captureConfig.spo2Drop = 3;
+  captureConfig.invalidHrHops = 8;
+  captureConfig.lowSignalIr = 50000;
+  capture.begin(captureConfig);
+  windows.begin(FS);
+  fusion.begin();
+  TelemetryConfig telemetryConfig;
+  telemetryConfig.hrDeadband = 2;
+  telemetryConfig.spo2Deadband = 1;
+  telemetryConfig.minIntervalMs = 1000;
+  telemetryConfig.keepAliveMs = 30000;
+  telemetry.begin(telemetryConfig);
+  hrTrack.begin(1.0f, 600000);
+  spo2Track.begin(1.0f, 600000);
+  memset(flash, 0xFF, sizeof(flash));
+  flashLog.begin("flashlog");
+}
+
+static void storePoints(char track, const TrackPoint *points, uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    FlashTrackRecord record;
+    record.ms = points[i].ms;
+    record.value = points[i].value;
+    record.track = track;
+    record.valid = points[i].valid;
+    flashLog.append(FLASH_RECORD_TRACK_POINT, &record, sizeof(record));
+  }
+}
+
+// One loop() pass; false while off the wrist
+static bool runHop(uint32_t hop, uint32_t *fusedValid) {
+  if (!contact.onSkin()) {
+    delay(250);
+    if (!contact.poll()) return false;
+    DLOG(CONTACT_ON);
+  }
+  for (int i = 0; i < HOP; i++) {
+    hostAdvanceMicros(1000000 / FS);
+    while (!sensor.available()) sensor.check();
+    uint32_t *sample = ring.claim();  // written in place, as readBatch() does
+    CHECK(sample);
+    if (!sample) return false;
+    sample[CH_RED] = sensor.getRed();
+    sample[CH_IR] = sensor.getIR();
+#if PPG_CHANNELS >= 3
+    sample[CH_GREEN] = sensor.getGreen();
+#endif
+    sensor.nextSample();
+    ring.commit();
+    lastIr = sample[CH_IR];
+    bool onSkin = contact.addSample(sample[CH_IR]);
+    uint32_t pulse = sample[PPG_HR_CHANNEL];
+    hrBank.addSample(pulse);
+    spectrumBank.addSample(pulse);
+    regression.addSample(sample[CH_RED], sample[CH_IR]);
+    morphology.addSample(pulse);
+    windows.addSample(regression);
+    capture.addSample(sample[CH_RED], sample[CH_IR]);
+    if (!onSkin) {
+      DLOG(CONTACT_LOST);
+      return false;
+    }
+  }
+
+  int32_t hr, spo2;
+  int8_t valid;
+  fusion.predict();
+  autocorr.update();
+  if (autocorr.estimate(&hr, &valid)) fusion.addHeartRate(hr, 100);
+  if (hrBank.estimate(&hr, &valid)) fusion.addHeartRate(hr, 100);
+  tracker.addColumn(spectrumBank);
+  if (tracker.estimate(&hr, &valid)) fusion.addHeartRate(hr, 180);
+  if (regression.estimate(&spo2, &valid)) fusion.addSpo2(spo2, 120);
+  nn.estimate(&hr, &valid);
+  templateDetector.update();
+  if (templateDetector.estimate(&hr, &valid)) fusion.addHeartRate(hr, 120);
+  BeatFeatures beat;
+  while (morphology.pop(&beat)) {
+    windows.addBeat(beat);
+    DLOG(BEAT, (int32_t)beat.amplitude, beat.ibiMs, beat.riseMs, beat.widthMs, beat.notchMs, beat.notchRatio);
+  }
+  WindowEstimate shortWindow, longWindow;
+  windows.estimate(2, &shortWindow);
+  windows.estimate(10, &longWindow);
+  if (longWindow.validHeartRate) fusion.addHeartRate(longWindow.heartRate, 100);
+
+  int32_t fusedHr = 0, fusedSpo2 = 0;
+  bool hrValid = fusion.heartRate(&fusedHr), spo2Valid = fusion.oxygenSaturation(&fusedSpo2);
+  *fusedValid += hrValid;
+  DLOG(FUSED, logValid(fusedHr, hrValid), LogValue(fusion.heartRateState().variance() / (float)KALMAN_ONE, 1),
+       logValid(fusedSpo2, spo2Valid), LogValue(fusion.spo2State().variance() / (float)KALMAN_ONE, 1), 0u);
+  telemetry.update(millis(), fusedHr, hrValid, fusedSpo2, spo2Valid, serial);
+
+  TrackPoint points[2];
+  storePoints('H', points, hrTrack.add(millis(), fusedHr, hrValid, points));
+  storePoints('S', points, spo2Track.add(millis(), fusedSpo2, spo2Valid, points));
+
+  if (hop == CAPTURE_AT_HOP) capture.trigger(CAPTURE_TRIGGER_MANUAL);
+  capture.checkVitals(fusedSpo2, spo2Valid, hrValid, lastIr);
+  capture.exportTo(serial, 50);
+  return true;
+}
+
+int main() {
+  printf("setting up\n");  // stdio's own buffers, before the seal
+  setupPipeline();
+  sealed = true;
+
+  uint32_t onHops = 0, fusedValid = 0;
+  uint32_t flashBefore = flashLog.nextSeq();
+  for (uint32_t hop = 0; hop < HOPS; hop++) onHops += runHop(hop, &fusedValid);
+  sealed = false;
+
+  printf("%u hops (%u on the wrist, %u with a fused HR), %u log/serial bytes, %u flash records: %u allocations\n",
+         HOPS, onHops, fusedValid, serial.bytes, flashLog.nextSeq() - flashBefore, allocs);
+  // The run exercised what it claims to
+  CHECK(onHops > HOPS * 9 / 10 && onHops < HOPS);
+  CHECK(fusedValid > onHops / 2);
+  CHECK(flashLog.nextSeq() > flashBefore);
+  CHECK(serial.bytes > 0);
+  CHECK(allocs == 0);
+
+  // And the counter does see an allocation
+  sealed = true;
+  void *p = malloc(16);
+  int *q = new int(1);
+  sealed = false;
+  free(p);
+  delete q;
+  CHECK(allocs == 2);
+  return hostTestResult();
+}
@@ -0,0 +1,82 @@
+// Dicrotic notch position on a synthetic beat with a known notch, and the
+// per-sample and per-beat cost of the morphology stage.
+// sources: pulse_morphology.cpp
+#include "pulse_morphology.h"
+#include "host_test.h"
+
+#define FS 100
+#define BPM 60.0f        // 100 samples per beat
+#define SECONDS 60
+#define SETTLE_BEATS 5   // DC tracker and slope threshold settle
+#define AMPLITUDE 1000.0f
+#define FILTER_LAG 1.5f  // samples, 8 Hz one-pole low-pass at 100 Hz
+
+// Systolic peak plus a dicrotic wave; the notch is the minimum between them
+static float pulse(float phase) {
+  return expf(-powf((phase - 0.2f) / 0.08f, 2)) + 0.4f * expf(-powf((phase - 0.5f) / 0.08f, 2));
+}
+
+static float notchPhase() {
+  float best = 0.2f;
+  for (float p = 0.2f; p < 0.5f; p += 1e-5f)
+    if (pulse(p) < pulse(best)) best = p;
+  return best;
+}
+
+int main() {
+  const float notch = notchPhase();
+  const uint32_t samplesPerBeat = (uint32_t)(FS * 60 / BPM);
+  PulseMorphology morphology;
+  morphology.begin(FS);
+
+  uint64_t sampleNanos = 0, beatNanos = 0;
+  uint32_t plainSamples = 0, beats = 0, notches = 0;
+  float worstOffset = 0;
+  for (uint32_t n = 0; n < SECONDS * FS; n++) {
+    float phase = fmodf(n / (float)samplesPerBeat, 1.0f);
+    uint32_t ir = (uint32_t)(100000 - AMPLITUDE * pulse(phase));
+    uint64_t start = hostNanos();
+    bool produced = morphology.addSample(ir);
+    uint64_t ns = hostNanos() - start;
+    if (!produced) {
+      sampleNanos += ns;
+      plainSamples++;
+      continue;
+    }
+    beatNanos += ns;
+
+    BeatFeatures beat;
+    while (morphology.pop(&beat)) {
+      if (++beats <= SETTLE_BEATS) continue;
+      CHECK(beat.notchMs > 0);
+      if (beat.notchMs == 0) continue;
+      notches++;
+      // notchMs is a whole number of 10 ms samples at 100 Hz
+      uint32_t k = beat.footIndex + beat.notchMs / 10;
+      CHECK(beat.notchMs % 10 == 0);
+      // The reported sample is the local minimum itself, not its neighbour
+      CHECK(morphology.at(k) < morphology.at(k - 1));
+      CHECK(morphology.at(k) <= morphology.at(k + 1));
+      float ratio = (morphology.at(k) - morphology.at(beat.footIndex)) / beat.amplitude;
+      CHECK(fabsf(beat.notchRatio - ratio) < 1e-5f);
+
+      // ...and sits where the synthetic beat puts it, after the filter's lag
+      float expected = (k / samplesPerBeat + notch) * samplesPerBeat + FILTER_LAG;
+      float offset = fabsf(k - expected);
+      if (offset > worstOffset) worstOffset = offset;
+    }
+  }
+  CHECK(notches + SETTLE_BEATS >= SECONDS * BPM / 60 - 2);
+  CHECK(worstOffset < 0.75f);  // a neighbouring sample would be ~1 off
+
+  // Closing a beat (peak, width, notch search, template fold) against the
+  // plain per-sample work it amortizes over
+  float perSample = (float)sampleNanos / plainSamples;
+  float perBeat = (float)beatNanos / beats - perSample;
+  printf("notch: %u beats, worst %.2f samples from the synthetic notch (phase %.3f)\n", notches, worstOffset, notch);
+  printf("cost: %.0f ns/sample, %.0f ns/beat close (%.1f samples' worth), %u bytes\n", perSample, perBeat,
+         perBeat / perSample, (unsigned)sizeof(PulseMorphology));
+  // The close walks the beat a few times: well under a beat's worth of samples
+  CHECK(perBeat < perSample * samplesPerBeat);
+  return hostTestResult();
+}
@@ -0,0 +1,69 @@
+// Regression SpO2: a value every hop that stays on the calibration curve
+// through baseline drift and skipped beats (which would drop a valley),
+// hop-to-hop stability, and cost per sample.
+// sources: regression_spo2.cpp fast_math.cpp
+#include "regression_spo2.h"
+#include "host_test.h"
+
+#define FS 100
+#define HOP 25
+#define SECONDS 60
+#define SETTLE_SEC 10
+#define BPM 72.0f
+#define IR_DC 100000.0f
+#define RED_DC 60000.0f
+#define PERFUSION 0.01f   // AC / DC on IR
+#define DRIFT 0.02f       // slow baseline swing (contact pressure), of DC
+#define DRIFT_HZ 0.05f
+#define SKIP_EVERY 5      // every 5th beat is missing
+#define NOISE 30          // counts, uniform
+
+int main() {
+  static const float ratios[] = {0.5f, 0.7f, 0.9f, 1.1f};
+  uint64_t nanos = 0;
+  uint32_t samples = 0;
+  for (float ratio : ratios) {
+    RegressionSpO2 engine;
+    engine.begin(FS);
+    HostPulse pulse;
+    float expected = maximSpo2Curve(ratio);
+    uint32_t scored = 0, valid = 0, beat = 0;
+    float sum = 0, sumSq = 0, previous = 0, stepSum = 0;
+    float lastPhase = 0;
+    for (uint32_t n = 0; n < SECONDS * FS; n++) {
+      float p = pulse.next(BPM, FS);
+      if (pulse.phase < lastPhase) beat++;
+      lastPhase = pulse.phase;
+      if (beat % SKIP_EVERY == SKIP_EVERY - 1) p = 0;
+      float wander = 1 + DRIFT * sinf(2 * PI * DRIFT_HZ * n / FS);
+      uint32_t ir = (uint32_t)(IR_DC * wander * (1 - PERFUSION * p) + NOISE * hostNoise());
+      uint32_t red = (uint32_t)(RED_DC * wander * (1 - ratio * PERFUSION * p) + NOISE * hostNoise());
+      uint64_t t0 = hostNanos();
+      engine.addSample(red, ir);
+      nanos += hostNanos() - t0;
+      samples++;
+      if (n % HOP != HOP - 1 || n < SETTLE_SEC * FS) continue;
+
+      int32_t spo2;
+      int8_t ok;
+      engine.estimate(&spo2, &ok);
+      scored++;
+      if (!ok) continue;
+      float value = maximSpo2Curve(engine.ratio());  // unrounded, for the spread
+      if (valid) stepSum += fabsf(value - previous);
+      previous = value;
+      valid++;
+      sum += value;
+      sumSq += value * value;
+    }
+    float mean = valid ? sum / valid : 0;
+    float sd = valid ? sqrtf(fmaxf(sumSq / valid - mean * mean, 0)) : 0;
+    printf("R %.1f (%.1f%%): valid %3.0f%% of hops, mean %.2f%%, sd %.2f, mean hop-to-hop change %.2f\n", ratio,
+           expected, 100.0f * valid / scored, mean, sd, valid > 1 ? stepSum / (valid - 1) : 0);
+    CHECK(valid >= scored * 95 / 100);
+    CHECK(fabsf(mean - expected) < 1.0f);
+    CHECK(sd < 1.0f);
+  }
+  printf("cost per sample: %.0f ns\n", nanos / (float)samples);
+  return hostTestResult();
+}
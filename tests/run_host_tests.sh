@@ -0,0 +1,36 @@
+#!/bin/sh
+# Build and run the host tests against the sketch sources.
+#   tests/run_host_tests.sh [name_test ...]
+# Each tests/*_test.cpp names the sketch sources it links in a
+# "// sources:" line; shim/ stands in for the Arduino core and ESP-IDF.
+# A "// variants:" line builds and runs the test once per listed compiler
+# flag (e.g. a compile-time profile), in order; HOST_TEST_OUT lets a later
+# variant read what an earlier one left there.
+set -e
+cd "$(dirname "$0")"
+SKETCH=../PPGRead_V1_01
+OUT=${TMPDIR:-/tmp}/ppg_host_tests
+CXX=${CXX:-g++}
+mkdir -p "$OUT"
+
+tests=$*
+[ -n "$tests" ] || tests=$(ls *_test.cpp | sed 's/\.cpp$//')
+
+export HOST_TEST_OUT="$OUT"
+
+failed=0
+for t in $tests; do
+  sources=$(sed -n 's|^// sources: *||p' "$t.cpp" | tr ' ' '\n' | sed "/^$/d; s|^|$SKETCH/|")
+  variants=$(sed -n 's|^// variants: *||p' "$t.cpp")
+  for v in ${variants:-""}; do
+    echo "== $t${v:+ $v}"
+    bin="$OUT/$t$(echo "$v" | tr -c 'A-Za-z0-9_\n' '_')"
+    if $CXX -std=gnu++17 -O2 -Wall -Wextra -Ishim -I$SKETCH $v -o "$bin" "$t.cpp" shim/arduino_shim.cpp $sources &&
+       "$bin"; then
+      :
+    else
+      failed=$((failed + 1))
+    fi
+  done
+done
+[ $failed -eq 0 ] || { echo "$failed test(s) failed"; exit 1; }
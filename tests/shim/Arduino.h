@@ -0,0 +1,68 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Just enough of the Arduino core to build the sketch modules on the host.
+// Time only moves when a test calls hostAdvanceMicros().
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+#define PI 3.14159265358979f
+#define HEX 16
+#define DEC 10
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void hostAdvanceMicros(uint32_t us);
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t n) {
+    for (size_t i = 0; i < n; i++) write(buf[i]);
+    return n;
+  }
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(long v, int base = DEC) { return printFormat(base == HEX ? "%lx" : "%ld", v); }
+  size_t print(unsigned long v, int base = DEC) { return printFormat(base == HEX ? "%lx" : "%lu", v); }
+  size_t print(int v, int base = DEC) { return print((long)v, base); }
+  size_t print(unsigned v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(double v, int digits = 2) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", digits, v);
+    return print(buf);
+  }
+  size_t println() { return print("\r\n"); }
+  template <typename T>
+  size_t println(T v) { return print(v) + println(); }
+  template <typename T>
+  size_t println(T v, int format) { return print(v, format) + println(); }
+
+private:
+  template <typename T>
+  size_t printFormat(const char *format, T v) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), format, v);
+    return print(buf);
+  }
+};
+
+class EspClass {
+public:
+  uint32_t getCycleCount() { return (uint32_t)micros() * 240; }
+  uint32_t getFreeHeap() { return 0; }
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef HOST_MAX30105_H
+#define HOST_MAX30105_H
+
+// Emulated MAX30102 for the host tests. Samples arrive at EMU_SAMPLE_RATE
+// on the host clock into a 32-deep FIFO (oldest overwritten). Each sample
+// has three slots, red, IR and green (or LED-off), read EMU_SLOT_US apart.
+// A slot's reading follows its LED current: skin reflects EMU_SKIN_GAIN
+// counts per step, open air only EMU_AIR_GAIN. Like the real MAX30102 it
+// has no proximity function, so PROX_INT never fires.
+//
+// A test can modulate the reflected light with a pulse and add ambient
+// light on top of every slot, LED-off included, at the slot's own time.
+
+#include <Arduino.h>
+
+#define EMU_SAMPLE_RATE 100
+#define EMU_FIFO_DEPTH 32
+#define EMU_SLOTS 3
+#define EMU_SLOT_US 500     // slot to slot: LED pulse width plus settling
+#define EMU_SKIN_GAIN 1000  // counts per LED current step on the skin
+#define EMU_AIR_GAIN 20     // counts per step with nothing in front
+#define EMU_AMBIENT 300     // counts the on-chip ambient cancellation leaves
+
+class MAX30105 {
+public:
+  // Where the sensor is, by host time; set by the test
+  bool (*onWrist)(unsigned long ms) = nullptr;
+  // Fraction of the reflected light absorbed by blood, by time in seconds
+  float (*pulseAt)(float seconds) = nullptr;
+  // Ambient light in counts, by time in seconds, added to every slot
+  float (*ambientAt)(float seconds) = nullptr;
+
+  void setPulseAmplitudeRed(uint8_t value) { red = value; }
+  void setPulseAmplitudeIR(uint8_t value) { ir = value; }
+  void setPulseAmplitudeGreen(uint8_t value) { green = value; }
+  void setPulseAmplitudeProximity(uint8_t) {}
+  void setProximityThreshold(uint8_t) {}
+  void enablePROXINT() {}
+  uint8_t getINT1() { return 0; }
+  void setLEDMode(uint8_t) {}
+
+  void clearFIFO() {
+    catchUp();
+    head = tail;
+  }
+
+  uint16_t check() {
+    uint32_t before = head - tail;
+    catchUp();
+    return head - tail - before;
+  }
+
+  bool available() { return head != tail; }
+  uint32_t getFIFORed() { return fifo[tail % EMU_FIFO_DEPTH][0]; }
+  uint32_t getFIFOIR() { return fifo[tail % EMU_FIFO_DEPTH][1]; }
+  uint32_t getFIFOGreen() { return fifo[tail % EMU_FIFO_DEPTH][2]; }
+  void nextSample() {
+    if (available()) tail++;
+  }
+
+  // Newest sample, as the library's getRed()/getIR()/getGreen() return
+  uint32_t getRed() { return newest(0); }
+  uint32_t getIR() { return newest(1); }
+  uint32_t getGreen() { return newest(2); }
+
+  uint8_t red = 0, ir = 0, green = 0;
+
+private:
+  uint32_t newest(uint8_t slot) {
+    catchUp();
+    return fifo[(head - 1) % EMU_FIFO_DEPTH][slot];
+  }
+
+  void catchUp() {
+    uint32_t due = (uint32_t)((uint64_t)micros() * EMU_SAMPLE_RATE / 1000000);
+    for (; produced < due; produced++) {
+      unsigned long ms = (unsigned long)((uint64_t)produced * 1000 / EMU_SAMPLE_RATE);
+      uint32_t gain = onWrist && onWrist(ms) ? EMU_SKIN_GAIN : EMU_AIR_GAIN;
+      const uint8_t current[EMU_SLOTS] = {red, ir, green};
+      uint32_t *sample = fifo[head++ % EMU_FIFO_DEPTH];
+      for (uint8_t slot = 0; slot < EMU_SLOTS; slot++) {
+        float t = (float)produced / EMU_SAMPLE_RATE + slot * EMU_SLOT_US * 1e-6f;
+        float light = (float)current[slot] * gain * (pulseAt ? 1 - pulseAt(t) : 1);
+        sample[slot] = (uint32_t)(light + EMU_AMBIENT + (ambientAt ? ambientAt(t) : 0) + 0.5f);
+      }
+      if (head - tail > EMU_FIFO_DEPTH) tail = head - EMU_FIFO_DEPTH;
+    }
+  }
+
+  uint32_t fifo[EMU_FIFO_DEPTH][EMU_SLOTS];
+  uint32_t head = 0, tail = 0;
+  uint32_t produced = 0;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+// In-memory NVS for the host tests. One blob per key, namespaces ignored;
+// hostNvsErase() stands in for a fresh flash.
+
+#include <Arduino.h>
+
+#define HOST_NVS_KEYS 4
+#define HOST_NVS_BLOB 64
+
+struct HostNvsEntry {
+  char key[16];
+  uint8_t data[HOST_NVS_BLOB];
+  size_t len;
+};
+
+inline HostNvsEntry hostNvs[HOST_NVS_KEYS];
+
+inline void hostNvsErase() { memset(hostNvs, 0, sizeof(hostNvs)); }
+
+class Preferences {
+public:
+  bool begin(const char *, bool readOnly = false) {
+    this->readOnly = readOnly;
+    return true;
+  }
+  void end() {}
+
+  size_t putBytes(const char *key, const void *value, size_t len) {
+    HostNvsEntry *entry = find(key, true);
+    if (readOnly || !entry || len > HOST_NVS_BLOB) return 0;
+    memcpy(entry->data, value, len);
+    entry->len = len;
+    return len;
+  }
+
+  size_t getBytes(const char *key, void *buf, size_t maxLen) {
+    HostNvsEntry *entry = find(key, false);
+    if (!entry || entry->len > maxLen) return 0;
+    memcpy(buf, entry->data, entry->len);
+    return entry->len;
+  }
+
+private:
+  HostNvsEntry *find(const char *key, bool create) {
+    for (HostNvsEntry &entry : hostNvs)
+      if (entry.len && strcmp(entry.key, key) == 0) return &entry;
+    if (!create) return NULL;
+    for (HostNvsEntry &entry : hostNvs)
+      if (!entry.len) {
+        strncpy(entry.key, key, sizeof(entry.key) - 1);
+        return &entry;
+      }
+    return NULL;
+  }
+
+  bool readOnly;
+};
+
+#endif
@@ -0,0 +1,10 @@
+#include <Arduino.h>
+
+EspClass ESP;
+
+static uint64_t hostMicros;
+
+unsigned long millis() { return (unsigned long)(hostMicros / 1000); }
+unsigned long micros() { return (unsigned long)hostMicros; }
+void delay(unsigned long ms) { hostMicros += (uint64_t)ms * 1000; }
+void hostAdvanceMicros(uint32_t us) { hostMicros += us; }
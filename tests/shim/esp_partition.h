@@ -0,0 +1,29 @@
+#ifndef HOST_ESP_PARTITION_H
+#define HOST_ESP_PARTITION_H
+
+// ESP-IDF partition API as declared by the IDF. The host tests that link a
+// flash user implement these functions over their own emulated flash.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef enum { ESP_PARTITION_TYPE_DATA = 1 } esp_partition_type_t;
+typedef enum { ESP_PARTITION_SUBTYPE_ANY = 0xff } esp_partition_subtype_t;
+
+typedef struct {
+  uint32_t address;
+  uint32_t size;
+  char label[17];
+} esp_partition_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t offset, void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t offset, const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size);
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+// Wakeup cause for the host tests: a test sets hostWakeupCause before the
+// code under test asks, standing in for the reset that preceded it.
+
+#include <stdint.h>
+
+typedef enum {
+  ESP_SLEEP_WAKEUP_UNDEFINED = 0,  // power-up or reset, not a wake from sleep
+  ESP_SLEEP_WAKEUP_TIMER = 4,
+} esp_sleep_wakeup_cause_t;
+
+inline esp_sleep_wakeup_cause_t hostWakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() { return hostWakeupCause; }
+
+#endif
@@ -0,0 +1,46 @@
+// Detection rate of the template matcher as perfusion drops.
+// sources: template_beat_detector.cpp pulse_morphology.cpp fast_math.cpp
+#include "template_beat_detector.h"
+#include "host_test.h"
+
+#define FS 100
+#define BPM 72.0f
+#define STRONG_SAMPLES 1500  // seeds the template at full amplitude
+#define COUNT_FROM 2000
+#define TOTAL_SAMPLES 6000   // 40 s counted: 48 beats at 72 bpm
+#define NOISE 20.0f          // counts, uniform
+
+// Systolic peak plus a dicrotic wave, inverted as IR absorption
+static float pulse(uint32_t n) {
+  float phase = fmodf(n / (float)FS * BPM / 60.0f, 1.0f);
+  return expf(-powf((phase - 0.2f) / 0.08f, 2)) + 0.4f * expf(-powf((phase - 0.5f) / 0.08f, 2));
+}
+
+int main() {
+  const int expected = (int)((TOTAL_SAMPLES - COUNT_FROM) / (float)FS * BPM / 60.0f);
+  static const float amplitudes[] = {600, 100, 50, 30, 20};
+  for (float amplitude : amplitudes) {
+    PulseMorphology morphology;
+    TemplateBeatDetector detector;
+    morphology.begin(FS);
+    detector.begin(&morphology, FS);
+    uint32_t beatsAtStart = 0;
+    for (uint32_t n = 0; n < TOTAL_SAMPLES; n++) {
+      float a = n < STRONG_SAMPLES ? 600.0f : amplitude;
+      morphology.addSample((uint32_t)(100000 - a * pulse(n) + NOISE * hostNoise()));
+      BeatFeatures beat;
+      while (morphology.pop(&beat)) {}
+      detector.update();
+      if (n == COUNT_FROM) beatsAtStart = detector.beats();
+    }
+    int32_t hr;
+    int8_t valid;
+    detector.estimate(&hr, &valid);
+    int detected = detector.beats() - beatsAtStart;
+    printf("amplitude %3.0f (SNR %4.1f): %d of %d beats, HR %d%s\n", amplitude, amplitude / NOISE, detected, expected,
+           hr, valid ? "" : " (invalid)");
+    CHECK(abs(detected - expected) <= 3);
+    CHECK(valid && abs(hr - (int)BPM) <= 2);
+  }
+  return hostTestResult();
+}
@@ -0,0 +1,77 @@
+// Cost of one fusion update and of a full hop with every engine reporting,
+// the smoothing it buys over a single engine, and coasting through a dropout.
+// sources: vitals_fusion.cpp
+#include "vitals_fusion.h"
+#include "host_test.h"
+
+#define HOPS 40000           // ~2.8 h at 4 hops/s
+#define HR_ENGINES 7         // as many as the sketch feeds per hop
+#define SPO2_ENGINES 3
+#define ENGINE_NOISE_BPM 6   // uniform +-, per engine
+#define DROPOUT_EVERY 400    // hops
+#define SHORT_DROPOUT 8      // 2 s: must coast
+#define LONG_DROPOUT 120     // 30 s: must give up
+
+static const uint8_t hrQuality[HR_ENGINES] = {80, 100, 180, 120, 150, 90, 60};
+
+int main() {
+  VitalsFusion fusion;
+  fusion.begin();
+
+  uint64_t hopNanos[2] = {0, 0};  // first and last quarter
+  uint32_t hopCount[2] = {0, 0};
+  uint32_t updates = 0, coasted = 0, shortDropoutHops = 0, longDropoutValid = 0;
+  double fusedSq = 0, rawSq = 0;
+  uint32_t scored = 0;
+  for (uint32_t hop = 0; hop < HOPS; hop++) {
+    float truth = 75 + 20 * sinf(hop * 2 * PI / 2400);  // 10 min swing
+    uint32_t phase = hop % DROPOUT_EVERY;
+    bool dropped = (hop / DROPOUT_EVERY) % 2 ? phase < LONG_DROPOUT : phase < SHORT_DROPOUT;
+    int32_t hr[HR_ENGINES], spo2[SPO2_ENGINES];
+    for (int32_t &v : hr) v = (int32_t)lroundf(truth + ENGINE_NOISE_BPM * hostNoise());
+    for (int32_t &v : spo2) v = (int32_t)lroundf(97 + 2 * hostNoise());
+
+    uint64_t start = hostNanos();
+    fusion.predict();
+    if (!dropped) {
+      for (uint8_t e = 0; e < HR_ENGINES; e++) fusion.addHeartRate(hr[e], hrQuality[e]);
+      for (uint8_t e = 0; e < SPO2_ENGINES; e++) fusion.addSpo2(spo2[e], 120);
+    }
+    int32_t fused;
+    bool valid = fusion.heartRate(&fused);
+    uint64_t ns = hostNanos() - start;
+
+    if (!dropped) updates += HR_ENGINES + SPO2_ENGINES;
+    if (hop < HOPS / 4 || hop >= HOPS * 3 / 4) {
+      hopNanos[hop >= HOPS / 2] += ns;
+      hopCount[hop >= HOPS / 2]++;
+    }
+    if (dropped && phase < SHORT_DROPOUT && hop >= DROPOUT_EVERY) {  // not the cold start
+      shortDropoutHops++;
+      coasted += valid;
+    }
+    if (dropped && phase >= LONG_DROPOUT - 4) longDropoutValid += valid;
+    if (!dropped && valid && hop > 100) {
+      fusedSq += (fused - truth) * (fused - truth);
+      rawSq += (hr[2] - truth) * (hr[2] - truth);  // the best single engine
+      scored++;
+    }
+  }
+
+  float early = (float)hopNanos[0] / hopCount[0], late = (float)hopNanos[1] / hopCount[1];
+  float perUpdate = late / (HR_ENGINES + SPO2_ENGINES);
+  float fusedRms = sqrtf(fusedSq / scored), rawRms = sqrtf(rawSq / scored);
+  printf("cost: %.0f ns/hop with %d engines (%.1f ns/update), first quarter %.0f ns/hop, %u bytes\n", late,
+         HR_ENGINES + SPO2_ENGINES, perUpdate, early, (unsigned)sizeof(VitalsFusion));
+  printf("HR rms error: fused %.2f bpm, best single engine %.2f bpm; coasted %u of %u short-dropout hops\n", fusedRms,
+         rawRms, coasted, shortDropoutHops);
+  CHECK(updates > 0);
+  // Fixed work per update: no growth with history, one division per update
+  CHECK(late < early * 2 && early < late * 2);
+  CHECK(perUpdate < 200);
+  CHECK(sizeof(VitalsFusion) <= 64);
+  CHECK(fusedRms < rawRms);
+  CHECK(coasted == shortDropoutHops);
+  CHECK(longDropoutValid == 0);
+  return hostTestResult();
+}
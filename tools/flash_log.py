@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""Read the vitals flash log (PPGRead_V1_01/flash_log.h) from a partition dump.
+
+  esptool.py read_flash <spiffs offset> <spiffs size> log.bin
+  flash_log.py log.bin
+
+Prints every intact record in sequence order as CSV:
+seq,type,fields... Boot records read "seq,boot,<slept seconds>" and track
+points "seq,point,<track>,<ms>,<value>" (empty value: gap start), the same
+points the sketch prints as P, lines. A torn record ends its sector, as on
+the device.
+
+Point times are on the device's track clock, which runs on across timer
+wakes (slept seconds > 0) and restarts at a cold boot (0). To keep them in
+order across the whole log, each cold boot is rebased to 1 ms after the
+last point before it.
+"""
+import struct
+import sys
+
+SECTOR_BYTES = 4096
+MAGIC = 0x474C5056
+MAX_PAYLOAD = 64
+SECTOR_HEADER = struct.Struct("<IIIHH")
+RECORD_HEADER = struct.Struct("<IHBB")
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def sector_records(image, start):
+    magic, sector_seq, first_seq, _, crc = SECTOR_HEADER.unpack_from(image, start)
+    if magic != MAGIC or crc != crc16(image[start:start + SECTOR_HEADER.size - 2]):
+        return None
+    records = []
+    seq = first_seq
+    pos = start + SECTOR_HEADER.size
+    end = start + SECTOR_BYTES
+    while pos + RECORD_HEADER.size <= end:
+        header = image[pos:pos + RECORD_HEADER.size]
+        if header == b"\xff" * RECORD_HEADER.size:
+            break
+        rec_seq, length, rec_type, _ = RECORD_HEADER.unpack(header)
+        size = (RECORD_HEADER.size + length + 2 + 3) & ~3
+        if rec_seq != seq or length > MAX_PAYLOAD or pos + size > end:
+            break
+        body = image[pos:pos + RECORD_HEADER.size + length]
+        (crc,) = struct.unpack_from("<H", image, pos + RECORD_HEADER.size + length)
+        if crc != crc16(body):
+            break
+        records.append((rec_seq, rec_type, body[RECORD_HEADER.size:]))
+        pos += size
+        seq += 1
+    return sector_seq, records
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    with open(sys.argv[1], "rb") as f:
+        image = f.read()
+
+    sectors = []
+    for start in range(0, len(image) - SECTOR_BYTES + 1, SECTOR_BYTES):
+        found = sector_records(image, start)
+        if found:
+            sectors.append(found)
+    if not sectors:
+        sys.exit("no log sectors in " + sys.argv[1])
+
+    # Sector sequences only grow; sort relative to the newest to survive wrap
+    newest = max(s for s, _ in sectors)
+    sectors.sort(key=lambda s: ((s[0] - newest + 0x80000000) & 0xFFFFFFFF))
+    offset = last = 0
+    for _, records in sectors:
+        for seq, rec_type, payload in records:
+            if rec_type == 1 and len(payload) == 4:
+                (slept,) = struct.unpack("<I", payload)
+                if slept == 0 and last:
+                    offset = last + 1
+                print("%d,boot,%d" % (seq, slept))
+            elif rec_type == 2 and len(payload) == 10:
+                ms, value, track, valid = struct.unpack("<IfcB", payload)
+                last = max(last, ms + offset)
+                print("%d,point,%s,%d,%s" % (seq, track.decode(), ms + offset, "%.1f" % value if valid else ""))
+            else:
+                print("%d,%d,%s" % (seq, rec_type, payload.hex()))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""Format deferred log lines (PPGRead_V1_01/debug_log.h) on the host.
+
+  log_decode.py LOG [--messages PPGRead_V1_01/log_messages.h] [--levels]
+  log_decode.py LOG --stats
+
+The string table is generated from log_messages.h each run, so decode with
+the tree the firmware was built from. L,<id>,<args> lines are formatted as
+the device would have printed them with LOG_DEFERRED 0; every other line
+(telemetry, tracks, capture, profiler) passes through unchanged, so the
+output can be fed to the other tools. --levels prefixes each message with
+its level. --stats reports bytes on the wire per log event against the same
+events formatted as text, overall and per message.
+"""
+import argparse
+import collections
+import os
+import re
+import sys
+
+ENTRY = re.compile(r'X\(\s*(\w+)\s*,\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+SPEC = re.compile(r"%(%|[-+ 0#]*\d*(?:\.(\d+))?([duxXfsv]))")
+DEFAULT_TABLE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "PPGRead_V1_01", "log_messages.h")
+
+
+def load_table(path):
+    with open(path) as f:
+        text = f.read()
+    return [(name, level, fmt.encode().decode("unicode_escape")) for name, level, fmt in ENTRY.findall(text)]
+
+
+def render(fmt, args):
+    args = iter(args)
+
+    def convert(m):
+        if m.group(1) == "%":
+            return "%"
+        arg = next(args, "")
+        if arg == "-":
+            return "--"
+        conv = m.group(3)
+        try:
+            if conv in "du":
+                return str(int(arg))
+            if conv in "xX":
+                return ("%" + conv) % int(arg)
+            if conv == "f":
+                digits = int(m.group(2)) if m.group(2) is not None else 2
+                return "%.*f" % (digits, float(arg))
+        except ValueError:
+            pass
+        return arg  # %s, %v, or a value that didn't parse
+
+    return SPEC.sub(convert, fmt)
+
+
+def decode_line(table, line):
+    fields = line.split(",")
+    try:
+        msg = int(fields[1])
+        name, level, fmt = table[msg]
+    except (ValueError, IndexError):
+        return None
+    return name, level, render(fmt, fields[2:])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log")
+    parser.add_argument("--messages", default=DEFAULT_TABLE)
+    parser.add_argument("--levels", action="store_true")
+    parser.add_argument("--stats", action="store_true")
+    args = parser.parse_args()
+
+    table = load_table(args.messages)
+    if not table:
+        sys.exit("no X(...) entries in " + args.messages)
+
+    wire = collections.Counter()
+    text = collections.Counter()
+    count = collections.Counter()
+    source = sys.stdin if args.log == "-" else open(args.log, errors="replace")
+    for raw in source:
+        line = raw.rstrip("\r\n")
+        decoded = decode_line(table, line) if line.startswith("L,") else None
+        if decoded is None:
+            if not args.stats:
+                print(line)
+            continue
+        name, level, message = decoded
+        if args.stats:
+            count[name] += 1
+            wire[name] += len(line) + 2  # println ends lines with \r\n
+            text[name] += len(message) + 2
+        else:
+            print("[%s] %s" % (level, message) if args.levels else message)
+
+    if args.stats:
+        events = sum(count.values())
+        if not events:
+            sys.exit("no L, lines in " + args.log)
+        print("%d events: %.1f bytes/event deferred, %.1f bytes/event as text (%.1fx)" % (
+            events, sum(wire.values()) / events, sum(text.values()) / events,
+            sum(text.values()) / sum(wire.values())))
+        for name, n in count.most_common():
+            print("  %-24s %6d  %5.1f -> %5.1f bytes" % (name, n, text[name] / n, wire[name] / n))
+
+
+if __name__ == "__main__":
+    main()
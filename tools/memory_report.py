@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Static RAM report for the sketch ELF (PPGRead_V1_01/memory_plan.h).
+
+  memory_report.py ELF [--nm TOOL] [--top N] [--budget BYTES] [--match TEXT]
+
+Lists the statically placed RAM (.data and .bss symbols) from nm, largest
+first, with totals per section. The pipeline allocates nothing after
+setup(), so this is its whole steady-state footprint apart from stacks and
+the framework's own heap use. --match keeps symbols whose demangled name
+contains TEXT (repeatable, e.g. --match Ring --match nn). --budget exits
+with status 1 when the listed symbols exceed BYTES. The ELF is in the
+Arduino build directory (Sketch > Export Compiled Binary, or --build-path).
+"""
+import argparse
+import collections
+import subprocess
+import sys
+
+SECTIONS = {"b": ".bss", "B": ".bss", "d": ".data", "D": ".data"}
+
+
+def read_symbols(nm, elf):
+    cmd = [nm, "-S", "-C", "--size-sort", "--defined-only", elf]
+    out = subprocess.run(cmd, check=True, capture_output=True, text=True).stdout.splitlines()
+    symbols = []
+    for line in out:
+        fields = line.split(" ", 3)
+        if len(fields) == 4 and fields[2] in SECTIONS:
+            symbols.append((int(fields[1], 16), SECTIONS[fields[2]], fields[3]))
+    return symbols
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf")
+    parser.add_argument("--nm", default="xtensa-esp32s3-elf-nm")
+    parser.add_argument("--top", type=int, default=30)
+    parser.add_argument("--budget", type=int)
+    parser.add_argument("--match", action="append", default=[])
+    args = parser.parse_args()
+
+    symbols = read_symbols(args.nm, args.elf)
+    if args.match:
+        symbols = [s for s in symbols if any(m in s[2] for m in args.match)]
+    if not symbols:
+        sys.exit("no RAM symbols in " + args.elf)
+    symbols.sort(reverse=True)
+
+    for size, section, name in symbols[: args.top]:
+        print("%8d  %-5s  %s" % (size, section, name))
+    if len(symbols) > args.top:
+        print("%8d  (%d more symbols)" % (sum(s[0] for s in symbols[args.top :]), len(symbols) - args.top))
+
+    per_section = collections.Counter()
+    for size, section, _ in symbols:
+        per_section[section] += size
+    total = sum(per_section.values())
+    print("%8d  total (%s)" % (total, ", ".join("%s %d" % kv for kv in sorted(per_section.items()))))
+
+    if args.budget is not None and total > args.budget:
+        print("over budget by %d bytes" % (total - args.budget), file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""Symbolize sampling-profiler output (PPGRead_V1_01/profiler.h).
+
+  profile_symbolize.py LOG ELF [--addr2line TOOL] [--summary]
+
+Reads the S,<pc hex>,<stage> lines and the PROFILE stage table from a serial
+log, resolves each distinct PC against the sketch ELF with addr2line
+(inlined frames included) and prints folded stacks, one per line:
+
+  <stage>;<function>;<inlined function> <count>
+
+which flamegraph.pl, speedscope and inferno read directly. The ELF is in the
+Arduino build directory (Sketch > Export Compiled Binary, or --build-path).
+--summary prints the share of samples per stage to stderr as well.
+"""
+import argparse
+import collections
+import subprocess
+import sys
+
+
+def read_log(path):
+    stages = {}
+    samples = collections.Counter()
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("PROFILE stage "):
+                _, _, index, name = line.split(" ", 3)
+                stages[int(index)] = name
+            elif line.startswith("S,"):
+                fields = line.split(",")
+                if len(fields) == 3:
+                    try:
+                        samples[(int(fields[1], 16), int(fields[2]))] += 1
+                    except ValueError:
+                        pass  # line cut by a reset
+    return stages, samples
+
+
+def symbolize(addr2line, elf, pcs):
+    """Map each PC to its frames, outermost first."""
+    pcs = sorted(pcs)
+    cmd = [addr2line, "-f", "-i", "-C", "-a", "-e", elf] + ["0x%x" % pc for pc in pcs]
+    out = subprocess.run(cmd, check=True, capture_output=True, text=True).stdout.splitlines()
+
+    frames = {}
+    current = None
+    i = 0
+    while i < len(out):
+        if out[i].startswith("0x"):
+            current = int(out[i], 16)
+            frames[current] = []
+            i += 1
+            continue
+        function = out[i]
+        i += 2  # skip file:line
+        frames[current].append("??" if function == "??" else function.replace(";", ":"))
+    for pc in pcs:
+        if not frames.get(pc) or frames[pc] == ["??"]:
+            frames[pc] = ["0x%x" % pc]
+        else:
+            frames[pc].reverse()  # addr2line -i lists the innermost frame first
+    return frames
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log")
+    parser.add_argument("elf")
+    parser.add_argument("--addr2line", default="xtensa-esp32s3-elf-addr2line")
+    parser.add_argument("--summary", action="store_true")
+    args = parser.parse_args()
+
+    stages, samples = read_log(args.log)
+    if not samples:
+        sys.exit("no S, profiler lines in " + args.log)
+    frames = symbolize(args.addr2line, args.elf, {pc for pc, _ in samples})
+
+    folded = collections.Counter()
+    for (pc, stage), count in samples.items():
+        name = stages.get(stage, "stage%d" % stage)
+        folded[";".join([name] + frames[pc])] += count
+    for stack, count in sorted(folded.items()):
+        print("%s %d" % (stack, count))
+
+    if args.summary:
+        total = sum(samples.values())
+        per_stage = collections.Counter()
+        for (_, stage), count in samples.items():
+            per_stage[stages.get(stage, "stage%d" % stage)] += count
+        for name, count in per_stage.most_common():
+            print("%-12s %5.1f%%" % (name, 100.0 * count / total), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
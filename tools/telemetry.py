@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Host side of the delta-only vitals telemetry (PPGRead_V1_01/telemetry.h).
+
+  telemetry.py reconstruct LOG [--period-ms 250]
+      Rebuild a regular HR/SpO2 series from the V, lines of a serial log by
+      holding each report until the next one. Prints CSV: ms,hr,spo2 (empty
+      field when invalid).
+
+  telemetry.py bench LOG [--hop-ms 250] [--hr-deadband 2] ...
+      Replay the per-hop "Fused HR" lines of a serial log through the same
+      encoder rules and report messages per hour against reporting every hop,
+      plus the worst hold error of the reconstructed series. V, lines already
+      in the log are counted too. The per-hop lines are DEBUG level, so
+      capture at LOG_LEVEL_DEBUG; run deferred logs through log_decode.py
+      first.
+"""
+import argparse
+import re
+import sys
+
+FUSED = re.compile(r"Fused HR: (?:(\d+) bpm|invalid|--).*Fused SpO2: (?:(\d+)%|invalid|--)")
+
+
+def parse_reports(lines):
+    for line in lines:
+        if not line.startswith("V,"):
+            continue
+        fields = line.strip().split(",")
+        if len(fields) != 5:
+            continue
+        ms = int(fields[1])
+        hr = int(fields[2]) if fields[2] else None
+        spo2 = int(fields[3]) if fields[3] else None
+        yield ms, hr, spo2, fields[4]
+
+
+def parse_fused(lines, hop_ms):
+    t = 0
+    for line in lines:
+        m = FUSED.search(line)
+        if not m:
+            continue
+        hr = int(m.group(1)) if m.group(1) else None
+        spo2 = int(m.group(2)) if m.group(2) else None
+        yield t, hr, spo2
+        t += hop_ms
+
+
+class Encoder:
+    """Mirror of VitalsTelemetry::update()."""
+
+    def __init__(self, hr_deadband, spo2_deadband, min_ms, keepalive_ms):
+        self.hr_deadband = hr_deadband
+        self.spo2_deadband = spo2_deadband
+        self.min_ms = min_ms
+        self.keepalive_ms = keepalive_ms
+        self.last = None
+
+    def update(self, ms, hr, spo2):
+        if self.last is None:
+            reason = "V"
+        else:
+            last_ms, last_hr, last_spo2 = self.last
+            elapsed = ms - last_ms
+            reason = None
+            if (hr is None) != (last_hr is None) or (spo2 is None) != (last_spo2 is None):
+                reason = "V"
+            elif (hr is not None and abs(hr - last_hr) >= self.hr_deadband) or \
+                    (spo2 is not None and abs(spo2 - last_spo2) >= self.spo2_deadband):
+                if elapsed >= self.min_ms:
+                    reason = "C"
+            elif elapsed >= self.keepalive_ms:
+                reason = "K"
+        if reason:
+            self.last = (ms, hr, spo2)
+        return reason
+
+
+def fmt(value):
+    return "" if value is None else str(value)
+
+
+def reconstruct(args):
+    with open(args.log, errors="replace") as f:
+        reports = list(parse_reports(f))
+    if not reports:
+        sys.exit("no V, lines in " + args.log)
+    print("ms,hr,spo2")
+    i = 0
+    for ms in range(reports[0][0], reports[-1][0] + 1, args.period_ms):
+        while i + 1 < len(reports) and reports[i + 1][0] <= ms:
+            i += 1
+        print("%d,%s,%s" % (ms, fmt(reports[i][1]), fmt(reports[i][2])))
+
+
+def bench(args):
+    with open(args.log, errors="replace") as f:
+        lines = f.readlines()
+
+    reports = list(parse_reports(lines))
+    if len(reports) > 1:
+        hours = (reports[-1][0] - reports[0][0]) / 3.6e6
+        print("device V lines: %d over %.2f h, %.0f messages/hour" % (len(reports), hours, len(reports) / hours))
+
+    hops = list(parse_fused(lines, args.hop_ms))
+    if len(hops) < 2:
+        sys.exit("no Fused HR lines to replay in " + args.log)
+    encoder = Encoder(args.hr_deadband, args.spo2_deadband, args.min_ms, args.keepalive_ms)
+    sent = 0
+    held = None
+    hr_err = spo2_err = 0
+    for ms, hr, spo2 in hops:
+        if encoder.update(ms, hr, spo2):
+            sent += 1
+            held = (hr, spo2)
+        if hr is not None and held[0] is not None:
+            hr_err = max(hr_err, abs(hr - held[0]))
+        if spo2 is not None and held[1] is not None:
+            spo2_err = max(spo2_err, abs(spo2 - held[1]))
+
+    hours = len(hops) * args.hop_ms / 3.6e6
+    print("replayed %d hops (%.2f h at %d ms/hop)" % (len(hops), hours, args.hop_ms))
+    print("every hop: %.0f messages/hour" % (len(hops) / hours))
+    print("delta-only: %.0f messages/hour (%.1f%%)" % (sent / hours, 100.0 * sent / len(hops)))
+    print("max hold error: HR %d bpm, SpO2 %d %%" % (hr_err, spo2_err))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("reconstruct")
+    p.add_argument("log")
+    p.add_argument("--period-ms", type=int, default=250)
+    p.set_defaults(func=reconstruct)
+
+    p = sub.add_parser("bench")
+    p.add_argument("log")
+    p.add_argument("--hop-ms", type=int, default=250)
+    p.add_argument("--hr-deadband", type=int, default=2)
+    p.add_argument("--spo2-deadband", type=int, default=1)
+    p.add_argument("--min-ms", type=int, default=1000)
+    p.add_argument("--keepalive-ms", type=int, default=30000)
+    p.set_defaults(func=bench)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Convert the stage-switch trace (PROFILE_TRACE in PPGRead_V1_01/profiler.h)
+to Chrome trace-event JSON.
+
+  trace_to_chrome.py LOG [-o trace.json]
+
+Reads T,<tid>,<us>,<stage> lines and the PROFILE stage table from a serial
+log. Each event opens its stage and closes the previous one on the same
+thread, so every pair of consecutive events becomes one complete ("X") span.
+micros() wrap-around is unwrapped, and spans that end at a gap marker (events
+lost to a full buffer) are left out. Open the result in chrome://tracing or
+ui.perfetto.dev.
+"""
+import argparse
+import collections
+import json
+import sys
+
+TRACE_GAP = 0xFF
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log")
+    parser.add_argument("-o", "--output", default="-")
+    args = parser.parse_args()
+
+    stages = {}
+    events = collections.defaultdict(list)
+    with open(args.log, errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("PROFILE stage "):
+                _, _, index, name = line.split(" ", 3)
+                stages[int(index)] = name
+            elif line.startswith("T,"):
+                fields = line.split(",")
+                if len(fields) == 4 and all(x.isdigit() for x in fields[1:]):
+                    events[int(fields[1])].append((int(fields[2]), int(fields[3])))
+    if not events:
+        sys.exit("no T, trace lines in " + args.log)
+
+    trace = [{"name": "thread_name", "ph": "M", "pid": 1, "tid": tid,
+              "args": {"name": "loop" if tid == 1 else "thread %d" % tid}} for tid in events]
+    for tid, thread_events in events.items():
+        wraps = 0
+        last = None
+        unwrapped = []
+        for us, stage in thread_events:
+            if last is not None and us < last:
+                wraps += 1
+            last = us
+            unwrapped.append((us + (wraps << 32), stage))
+        for (start, stage), (end, next_stage) in zip(unwrapped, unwrapped[1:]):
+            if stage == TRACE_GAP or next_stage == TRACE_GAP:
+                continue
+            trace.append({"name": stages.get(stage, "stage%d" % stage), "cat": "pipeline", "ph": "X",
+                          "pid": 1, "tid": tid, "ts": start, "dur": end - start})
+
+    out = sys.stdout if args.output == "-" else open(args.output, "w")
+    json.dump({"traceEvents": trace, "displayTimeUnit": "ms"}, out)
+    if out is not sys.stdout:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""Host side of the swinging-door vitals tracks (PPGRead_V1_01/swinging_door.h).
+
+  vitals_track.py decode LOG [--track H|S] [--at MS ...] [--period-ms N]
+      Random access into the archived P, points of a log: each query is a
+      binary search for the enclosing segment plus a linear interpolation.
+      Prints CSV: ms,value (empty inside a gap). The device's track clock
+      runs on across timer wakes but restarts at a cold boot; a log spanning
+      cold boots is laid end to end, each boot 1 ms after the last point of
+      the one before, with a gap in between.
+
+  vitals_track.py bench [--hours 8] [--deviation 1.0]
+      Compress a synthetic overnight HR track (250 ms hops) with the same
+      algorithm and report the compression ratio, the largest reconstruction
+      error and the encode time per sample on this host.
+"""
+import argparse
+import bisect
+import math
+import random
+import sys
+import time
+
+
+class Track:
+    def __init__(self, points):
+        self.points = sorted(points, key=lambda p: p[0])  # stable: a gap stays ahead of a point at its time
+        self.times = [p[0] for p in self.points]
+
+    def at(self, ms):
+        i = bisect.bisect_right(self.times, ms) - 1
+        if i < 0:
+            return None
+        t0, v0 = self.points[i]
+        if v0 is None:
+            return None
+        if t0 == ms or i + 1 == len(self.points):
+            return v0
+        t1, v1 = self.points[i + 1]
+        if v1 is None:
+            return v0  # last valid sample before a gap
+        return v0 + (v1 - v0) * (ms - t0) / (t1 - t0)
+
+
+def parse_points(lines, track):
+    offset = last = 0
+    for line in lines:
+        if not line.startswith("P,"):
+            continue
+        fields = line.strip().split(",")
+        if len(fields) != 4 or fields[1] != track:
+            continue
+        ms = int(fields[2])
+        if ms + offset < last:  # cold boot: the clock started over
+            offset = last + 1
+            yield offset, None
+        last = ms + offset
+        yield last, float(fields[3]) if fields[3] else None
+
+
+class SwingingDoor:
+    """Mirror of SwingingDoor::add(); archived points as (ms, value or None)."""
+
+    def __init__(self, deviation, max_span_ms):
+        self.deviation = deviation
+        self.max_span_ms = max_span_ms
+        self.active = False
+        self.gap = False
+        self.last = None
+
+    def close(self):
+        if not self.active or self.last is None:
+            return []
+        point = (self.last, self.anchor[1] + 0.5 * (self.upper + self.lower) * (self.last - self.anchor[0]))
+        self.anchor = point
+        self.last = None
+        return [point]
+
+    def add(self, ms, value):
+        if value is None:
+            if self.gap:
+                return []
+            out = self.close() + [(ms, None)]
+            self.active = False
+            self.gap = True
+            return out
+        if not self.active:
+            self.active, self.gap, self.last = True, False, None
+            self.anchor = (ms, value)
+            return [self.anchor]
+        out = []
+        dt = ms - self.anchor[0]
+        up = (value + self.deviation - self.anchor[1]) / dt
+        low = (value - self.deviation - self.anchor[1]) / dt
+        if self.last is not None:
+            up, low = min(self.upper, up), max(self.lower, low)
+            if low > up or ms - self.anchor[0] > self.max_span_ms:
+                out = self.close()
+                dt = ms - self.anchor[0]
+                up = (value + self.deviation - self.anchor[1]) / dt
+                low = (value - self.deviation - self.anchor[1]) / dt
+        self.upper, self.lower, self.last = up, low, ms
+        return out
+
+    def flush(self):
+        return self.close()
+
+
+def overnight(hours, hop_ms, seed=1):
+    """Sleeping HR: slow drift, sleep-cycle swings, arousals and dropouts."""
+    rng = random.Random(seed)
+    hr = 62.0
+    samples = []
+    n = int(hours * 3.6e6 / hop_ms)
+    dropout = 0
+    for i in range(n):
+        ms = i * hop_ms
+        cycle = 4 * math.sin(2 * math.pi * ms / 5.4e6)  # ~90 min cycles
+        hr += rng.gauss(0, 0.15) - 0.002 * (hr - 58)
+        if rng.random() < 1 / 7200:
+            hr += rng.uniform(8, 20)  # arousal
+        if dropout == 0 and rng.random() < 1 / 14400:
+            dropout = rng.randint(8, 240)  # lost contact
+        if dropout:
+            dropout -= 1
+            samples.append((ms, None))
+        else:
+            samples.append((ms, float(round(hr + cycle))))
+    return samples
+
+
+def decode(args):
+    with open(args.log, errors="replace") as f:
+        track = Track(parse_points(f, args.track))
+    if not track.points:
+        sys.exit("no P,%s lines in %s" % (args.track, args.log))
+    if args.at:
+        queries = args.at
+    else:
+        queries = range(track.times[0], track.times[-1] + 1, args.period_ms)
+    print("ms,value")
+    for ms in queries:
+        value = track.at(ms)
+        print("%d,%s" % (ms, "" if value is None else "%.1f" % value))
+
+
+def bench(args):
+    samples = overnight(args.hours, args.hop_ms)
+    sd = SwingingDoor(args.deviation, args.max_span_ms)
+    points = []
+    start = time.perf_counter()
+    for ms, value in samples:
+        points += sd.add(ms, value)
+    points += sd.flush()
+    elapsed = time.perf_counter() - start
+
+    track = Track(points)
+    worst = max(abs(track.at(ms) - v) for ms, v in samples if v is not None)
+    print("%d samples over %.1f h, %d archived points" % (len(samples), args.hours, len(points)))
+    print("compression ratio: %.1fx" % (len(samples) / len(points)))
+    print("max error: %.3f (bound %.3f)" % (worst, args.deviation))
+    print("encode: %.2f us/sample (host Python)" % (elapsed * 1e6 / len(samples)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("decode")
+    p.add_argument("log")
+    p.add_argument("--track", default="H", choices=["H", "S"])
+    p.add_argument("--at", type=int, nargs="*")
+    p.add_argument("--period-ms", type=int, default=1000)
+    p.set_defaults(func=decode)
+
+    p = sub.add_parser("bench")
+    p.add_argument("--hours", type=float, default=8)
+    p.add_argument("--hop-ms", type=int, default=250)
+    p.add_argument("--deviation", type=float, default=1.0)
+    p.add_argument("--max-span-ms", type=int, default=600000)
+    p.set_defaults(func=bench)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()